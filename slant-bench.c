@@ -0,0 +1,352 @@
+/*	$Id$ */
+/*
+ * Copyright (c) 2018 Kristaps Dzonsons <kristaps@bsd.lv>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include "config.h"
+
+#include <err.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "slant-proc.h"
+
+/*
+ * Compare the throughput of the tokenisers in slant-proc.c with the
+ * sscanf(3) parsing they replaced, on /proc files captured into a
+ * directory.
+ * Each parser returns a checksum of the values it extracts, or -1 on
+ * parse failure, so that we can check both agree before timing them.
+ */
+
+typedef int64_t (*parser)(char *, size_t);
+
+static int64_t
+old_stat(char *buf, size_t sz)
+{
+	uint64_t v[CPUSTATES];
+	int64_t	 sum = 0;
+	size_t	 i;
+
+	if (CPUSTATES != sscanf(buf, "cpu"
+	    " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64
+	    " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64,
+	    &v[0], &v[1], &v[2], &v[3], &v[4],
+	    &v[5], &v[6], &v[7], &v[8], &v[9]))
+		return -1;
+	for (i = 0; i < CPUSTATES; i++)
+		sum += v[i];
+	return sum;
+}
+
+static int64_t
+new_stat(char *buf, size_t sz)
+{
+	uint64_t v[CPUSTATES];
+	int64_t	 sum = 0;
+	size_t	 i;
+
+	if ( ! parse_stat(buf, sz, v))
+		return -1;
+	for (i = 0; i < CPUSTATES; i++)
+		sum += v[i];
+	return sum;
+}
+
+/*
+ * The tokeniser also extracts the available memory and swap, so do the
+ * same here to compare like with like.
+ */
+static int64_t
+old_meminfo(char *buf, size_t sz)
+{
+	static const char *const keys[] = {
+		"MemTotal:", "MemFree:", "MemAvailable:",
+		"SwapTotal:", "SwapFree:" };
+	uint64_t v[5];
+	char	*ptr;
+	size_t	 i;
+
+	for (i = 0; i < 5; i++)
+		if (NULL == (ptr = memmem(buf, sz, 
+		    keys[i], strlen(keys[i]))) ||
+		    1 != sscanf(ptr + strlen(keys[i]), 
+		    "%" SCNu64, &v[i]))
+			return -1;
+	return v[0] + v[1] + v[2] + v[3] + v[4];
+}
+
+static int64_t
+new_meminfo(char *buf, size_t sz)
+{
+	struct meminfo	 mi;
+
+	if ( ! parse_meminfo(buf, sz, &mi))
+		return -1;
+	return mi.total + mi.free + mi.avail + 
+		mi.swaptotal + mi.swapfree;
+}
+
+static int64_t
+old_netdev(char *buf, size_t sz)
+{
+	struct ifcount	 ifc;
+	char		*ptr, *end = buf + sz;
+	int64_t		 sum = 0;
+
+	/* Skip two header lines. */
+
+	if (NULL == (ptr = strchr(buf, '\n')) ||
+	    NULL == (ptr = strchr(ptr + 1, '\n')))
+		return -1;
+
+	for (ptr++; ptr < end; ptr++) {
+		for ( ; ' ' == *ptr; ptr++)
+			continue;
+		if (NULL == (ptr = strchr(ptr, ':')))
+			return -1;
+		*ptr++ = '\0';
+		if (7 != sscanf(ptr,
+		    " %" SCNu64 " %" SCNu64 " %" SCNu64
+		    " %*u %*u %*u %*u %*u"
+		    " %" SCNu64 " %" SCNu64 " %" SCNu64
+		    " %*u %*u %" SCNu64 " %*u %*u",
+		    &ifc.ifc_ib, &ifc.ifc_ip, &ifc.ifc_ie,
+		    &ifc.ifc_ob, &ifc.ifc_op, &ifc.ifc_oe,
+		    &ifc.ifc_co))
+			return -1;
+		sum += ifc.ifc_ib + ifc.ifc_ip + ifc.ifc_ie +
+			ifc.ifc_ob + ifc.ifc_op + ifc.ifc_oe +
+			ifc.ifc_co;
+		if (NULL == (ptr = strchr(ptr, '\n')))
+			break;
+	}
+	return sum;
+}
+
+static int64_t
+new_netdev(char *buf, size_t sz)
+{
+	struct ifcount	 ifc;
+	char		*ptr, *name;
+	const char	*end = buf + sz;
+	int64_t		 sum = 0;
+	int		 c;
+
+	ptr = tok_eol(tok_eol(buf, end), end);
+	while (0 != (c = parse_netdev(&ptr, end, &name, &ifc))) {
+		if (c < 0)
+			return -1;
+		sum += ifc.ifc_ib + ifc.ifc_ip + ifc.ifc_ie +
+			ifc.ifc_ob + ifc.ifc_op + ifc.ifc_oe +
+			ifc.ifc_co;
+	}
+	return sum;
+}
+
+static int64_t
+old_diskstats(char *buf, size_t sz)
+{
+	unsigned long	 secrd, secwr;
+	char		 name[128], *ptr;
+	int64_t		 sum = 0;
+
+	for (ptr = buf; ptr < buf + sz; ptr++) {
+		if (3 != sscanf(ptr, "%*u %*u %127s "
+		    "%*u %*u %lu %*u %*u %*u %lu %*u %*u %*u %*u",
+		    name, &secrd, &secwr))
+			return -1;
+		if (NULL == (ptr = strchr(ptr, '\n')))
+			return -1;
+		sum += secrd + secwr;
+	}
+	return sum;
+}
+
+static int64_t
+new_diskstats(char *buf, size_t sz)
+{
+	struct discio	 io;
+	char		*ptr = buf, *name;
+	int64_t		 sum = 0;
+	int		 c;
+
+	while (0 != (c = parse_diskstats(&ptr, buf + sz, &name, &io))) {
+		if (c < 0)
+			return -1;
+		sum += io.secrd + io.secwr;
+	}
+	return sum;
+}
+
+static	const struct bench {
+	const char	*file; /* captured file in the directory */
+	parser		 old; /* sscanf(3) version */
+	parser		 new; /* tokeniser version */
+} benches[] = {
+	{ "stat", old_stat, new_stat },
+	{ "meminfo", old_meminfo, new_meminfo },
+	{ "net-dev", old_netdev, new_netdev },
+	{ "diskstats", old_diskstats, new_diskstats },
+};
+
+#define	BENCH__MAX (sizeof(benches) / sizeof(benches[0]))
+
+/*
+ * Read all of "fn" into a NUL-terminated buffer of size "sz".
+ * Returns NULL on failure.
+ */
+static char *
+readfile(const char *fn, size_t *sz)
+{
+	FILE	*f;
+	char	*buf;
+	long	 len;
+
+	if (NULL == (f = fopen(fn, "r"))) {
+		warn("%s", fn);
+		return NULL;
+	}
+	if (-1 == fseek(f, 0, SEEK_END) || -1 == (len = ftell(f)) ||
+	    -1 == fseek(f, 0, SEEK_SET)) {
+		warn("%s", fn);
+		fclose(f);
+		return NULL;
+	}
+	if (NULL == (buf = malloc(len + 1))) {
+		warn(NULL);
+		fclose(f);
+		return NULL;
+	}
+	if ((size_t)len != fread(buf, 1, len, f)) {
+		warnx("%s: short read", fn);
+		fclose(f);
+		free(buf);
+		return NULL;
+	}
+	fclose(f);
+	buf[len] = '\0';
+	*sz = len;
+	return buf;
+}
+
+/*
+ * Run "fp" "count" times over a fresh copy of "src" in "buf" (as both
+ * parsers write into it), returning the seconds taken or -1 on failure.
+ */
+static double
+run(parser fp, const char *src, char *buf, size_t sz, long long count)
+{
+	struct timespec	 start, end;
+	long long	 i;
+
+	if (-1 == clock_gettime(CLOCK_MONOTONIC, &start)) {
+		warn("clock_gettime");
+		return -1.0;
+	}
+	for (i = 0; i < count; i++) {
+		memcpy(buf, src, sz + 1);
+		if (fp(buf, sz) < 0)
+			return -1.0;
+	}
+	if (-1 == clock_gettime(CLOCK_MONOTONIC, &end)) {
+		warn("clock_gettime");
+		return -1.0;
+	}
+	return (end.tv_sec - start.tv_sec) +
+		(end.tv_nsec - start.tv_nsec) / 1000000000.0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	const struct bench *b;
+	const char	*er, *dir;
+	char		*src, *buf, fn[PATH_MAX];
+	size_t		 i, sz;
+	long long	 count = 100000;
+	int64_t		 oldsum, newsum;
+	double		 oldt, newt, mb;
+	int		 c, rc = 0;
+
+	while (-1 != (c = getopt(argc, argv, "n:")))
+		switch (c) {
+		case 'n':
+			count = strtonum(optarg, 1, LLONG_MAX, &er);
+			if (NULL != er)
+				errx(EXIT_FAILURE, "-n: %s", er);
+			break;
+		default:
+			goto usage;
+		}
+
+	argc -= optind;
+	argv += optind;
+	if (1 != argc)
+		goto usage;
+	dir = argv[0];
+
+	printf("%-10s %8s %12s %12s %8s\n",
+		"file", "bytes", "sscanf MB/s", "tok MB/s", "speedup");
+
+	for (i = 0; i < BENCH__MAX; i++) {
+		b = &benches[i];
+		snprintf(fn, sizeof(fn), "%s/%s", dir, b->file);
+		if (NULL == (src = readfile(fn, &sz)))
+			goto out;
+		if (NULL == (buf = malloc(sz + 1))) {
+			warn(NULL);
+			free(src);
+			goto out;
+		}
+
+		/* Both must parse and agree before we time them. */
+
+		memcpy(buf, src, sz + 1);
+		oldsum = b->old(buf, sz);
+		memcpy(buf, src, sz + 1);
+		newsum = b->new(buf, sz);
+		if (oldsum < 0 || newsum < 0 || oldsum != newsum) {
+			warnx("%s: parsers disagree: %" PRId64
+				" (sscanf), %" PRId64, fn, oldsum, newsum);
+			free(src);
+			free(buf);
+			goto out;
+		}
+
+		oldt = run(b->old, src, buf, sz, count);
+		newt = run(b->new, src, buf, sz, count);
+		free(src);
+		free(buf);
+		if (oldt < 0.0 || newt < 0.0)
+			goto out;
+
+		mb = (double)sz * count / (1024.0 * 1024.0);
+		printf("%-10s %8zu %12.1f %12.1f %7.1fx\n", b->file,
+			sz, mb / oldt, mb / newt, oldt / newt);
+	}
+
+	rc = 1;
+out:
+	return rc ? EXIT_SUCCESS : EXIT_FAILURE;
+usage:
+	fprintf(stderr, "usage: %s [-n count] dir\n", getprogname());
+	return EXIT_FAILURE;
+}
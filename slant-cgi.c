@@ -31,19 +31,84 @@
 
 #include <kcgi.h>
 #include <kcgijson.h>
+#include <sqlite3.h>
 
 #include "params.h"
 #include "extern.h"
 #include "db.h"
 #include "json.h"
+#include "slant-chunk.h"
+#include "slant-ring.h"
+#include "slant-rollup.h"
+#include "slant-summary.h"
+
+/*
+ * Milliseconds to wait for the collector to release its lock.
+ */
+#define	BUSY_TIMEOUT 5000
 
 enum	page {
 	PAGE_INDEX,
+	PAGE_HISTORY,
 	PAGE__MAX
 };
 
 static const char *const pages[PAGE__MAX] = {
 	"index", /* PAGE_INDEX */
+	"history", /* PAGE_HISTORY */
+};
+
+enum	key {
+	KEY_DEVICES,
+	KEY_METRICS,
+	KEY_SEC,
+	KEY_STAGES,
+	KEY_INTERVAL,
+	KEY_SINCE,
+	KEY_UNTIL,
+	KEY__MAX
+};
+
+/*
+ * Query string keys.
+ * The values of "devices" and "stages" are ignored: only whether
+ * they're present.
+ */
+static const struct kvalid keys[KEY__MAX] = {
+	{ NULL, "devices" }, /* KEY_DEVICES */
+	{ NULL, "metrics" }, /* KEY_METRICS */
+	{ NULL, "sec" }, /* KEY_SEC */
+	{ NULL, "stages" }, /* KEY_STAGES */
+	{ kvalid_stringne, "interval" }, /* KEY_INTERVAL */
+	{ kvalid_int, "since" }, /* KEY_SINCE */
+	{ kvalid_int, "until" }, /* KEY_UNTIL */
+};
+
+/*
+ * Interval names as used in the index document.
+ */
+static const struct ivaldef {
+	const char	*name;
+	enum interval	 ival;
+} ivaldefs[] = {
+	{ "sec", INTERVAL_bysec },
+	{ "qmin", INTERVAL_byqmin },
+	{ "min", INTERVAL_bymin },
+	{ "hour", INTERVAL_byhour },
+	{ "day", INTERVAL_byday },
+	{ "week", INTERVAL_byweek },
+	{ "year", INTERVAL_byyear },
+	{ NULL, INTERVAL_byqmin }
+};
+
+/*
+ * Per-device rows of the newest record of each interval.
+ */
+struct	devices {
+	int64_t			 ids[32]; /* the records */
+	struct ifrecord_q	*ifs[32];
+	struct discrecord_q	*discs[32];
+	size_t			 sz;
 };
 
 /*
@@ -61,12 +126,457 @@ http_open(struct kreq *r, enum khttp code)
 	khttp_body(r);
 }
 
+/*
+ * Add the rates "tx" and "rx" of interface "name" to those of the same
+ * name in "q", appending it as a row of record "id" if not yet in it.
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+ifs_put(struct ifrecord_q *q, int64_t id, 
+	const char *name, int64_t tx, int64_t rx)
+{
+	struct ifrecord	*ir;
+
+	TAILQ_FOREACH(ir, q, _entries)
+		if (0 == strcmp(ir->name, name))
+			break;
+	if (NULL == ir) {
+		if (NULL == (ir = calloc(1, sizeof(struct ifrecord))))
+			return 0;
+		if (NULL == (ir->name = strdup(name))) {
+			free(ir);
+			return 0;
+		}
+		ir->recordid = id;
+		TAILQ_INSERT_TAIL(q, ir, _entries);
+	}
+	ir->nettx += tx;
+	ir->netrx += rx;
+	return 1;
+}
+
+/*
+ * Like ifs_put(), but for discs.
+ */
+static int
+discs_put(struct discrecord_q *q, int64_t id, 
+	const char *name, int64_t rd, int64_t wr)
+{
+	struct discrecord *dr;
+
+	TAILQ_FOREACH(dr, q, _entries)
+		if (0 == strcmp(dr->name, name))
+			break;
+	if (NULL == dr) {
+		if (NULL == (dr = calloc(1, sizeof(struct discrecord))))
+			return 0;
+		if (NULL == (dr->name = strdup(name))) {
+			free(dr);
+			return 0;
+		}
+		dr->recordid = id;
+		TAILQ_INSERT_TAIL(q, dr, _entries);
+	}
+	dr->discread += rd;
+	dr->discwrite += wr;
+	return 1;
+}
+
+/*
+ * Add the ring file rows "rd" to "iq" and "dq" as those of record
+ * "id".
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+devices_put_ring(struct ifrecord_q *iq, struct discrecord_q *dq,
+	int64_t id, const struct ringdevs *rd)
+{
+	size_t	 i;
+
+	for (i = 0; i < rd->ifsz; i++)
+		if ( ! ifs_put(iq, id, rd->ifs[i].name, 
+		    rd->ifs[i].tx, rd->ifs[i].rx))
+			return 0;
+	for (i = 0; i < rd->discsz; i++)
+		if ( ! discs_put(dq, id, rd->discs[i].name, 
+		    rd->discs[i].rx, rd->discs[i].tx))
+			return 0;
+	return 1;
+}
+
+/*
+ * Add the rows "siq" and "sdq" (either may be NULL) to "iq" and "dq"
+ * as those of record "id".
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+devices_put(struct ifrecord_q *iq, struct discrecord_q *dq, int64_t id,
+	const struct ifrecord_q *siq, const struct discrecord_q *sdq)
+{
+	const struct ifrecord *ir;
+	const struct discrecord *dr;
+
+	if (NULL != siq)
+		TAILQ_FOREACH(ir, siq, _entries)
+			if ( ! ifs_put(iq, id, ir->name, 
+			    ir->nettx, ir->netrx))
+				return 0;
+	if (NULL != sdq)
+		TAILQ_FOREACH(dr, sdq, _entries)
+			if ( ! discs_put(dq, id, dr->name, 
+			    dr->discread, dr->discwrite))
+				return 0;
+	return 1;
+}
+
+/*
+ * Set the rows of record "id" in "d" to "iq" and "dq", which it then
+ * owns, freeing any it had.
+ */
 static void
-sendindex(struct kreq *r, 
-	const struct system *sys, const struct record_q *q)
+devices_set(struct devices *d, int64_t id, 
+	struct ifrecord_q *iq, struct discrecord_q *dq)
+{
+	size_t	 i;
+
+	for (i = 0; i < d->sz; i++)
+		if (id == d->ids[i])
+			break;
+	if (i == d->sz) {
+		if (d->sz == sizeof(d->ids) / sizeof(d->ids[0])) {
+			db_ifrecord_freeq(iq);
+			db_discrecord_freeq(dq);
+			return;
+		}
+		d->sz++;
+	} else {
+		db_ifrecord_freeq(d->ifs[i]);
+		db_discrecord_freeq(d->discs[i]);
+	}
+	d->ids[i] = id;
+	d->ifs[i] = iq;
+	d->discs[i] = dq;
+}
+
+/*
+ * Get the per-device rows of the newest record of each interval from
+ * the newest-first records "q" or, for the intervals it keeps, from the
+ * oldest-first ring file records "ring" with rows "rd", if not NULL.
+ */
+static void
+devices_get(struct ort *db, const struct record_q *q, 
+	const struct record *ring, const struct ringdevs *rd,
+	size_t ringsz, struct devices *d)
 {
-	struct kjsonreq	 req;
 	const struct record *rr;
+	struct ifrecord_q *iq;
+	struct discrecord_q *dq;
+	uint32_t	 seen = 0;
+	size_t		 i;
+
+	for (i = ringsz; NULL != ring && i > 0; i--) {
+		rr = &ring[i - 1];
+		if (seen & (1U << rr->interval))
+			continue;
+		seen |= 1U << rr->interval;
+		iq = malloc(sizeof(struct ifrecord_q));
+		dq = malloc(sizeof(struct discrecord_q));
+		if (NULL != iq)
+			TAILQ_INIT(iq);
+		if (NULL != dq)
+			TAILQ_INIT(dq);
+		if (NULL == iq || NULL == dq ||
+		    ! devices_put_ring(iq, dq, rr->id, &rd[i - 1])) {
+			db_ifrecord_freeq(iq);
+			db_discrecord_freeq(dq);
+			iq = NULL;
+			dq = NULL;
+		}
+		devices_set(d, rr->id, iq, dq);
+	}
+
+	TAILQ_FOREACH(rr, q, _entries) {
+		if (rr->interval >= 32 || (seen & (1U << rr->interval)) ||
+		    (NULL != ring && ring_has(rr->interval)))
+			continue;
+		seen |= 1U << rr->interval;
+		devices_set(d, rr->id, 
+			db_ifrecord_list_record(db, rr->id),
+			db_discrecord_list_record(db, rr->id));
+	}
+}
+
+/*
+ * Note "rr" in "heads" if it's the newest of its interval yet.
+ */
+static void
+rollup_newest(struct record **heads, struct record *rr)
+{
+
+	if ((size_t)rr->interval < ROLLUP_IVALS &&
+	    (NULL == heads[rr->interval] ||
+	     heads[rr->interval]->ctime < rr->ctime))
+		heads[rr->interval] = rr;
+}
+
+/*
+ * Add the per-device rows of record "rr" to "iq" and "dq" as those of
+ * record "id".
+ * These are its rows in "d" if there, else those of the ring file
+ * rows "rd" if it's of the "ringsz" ring records, else those in the
+ * database.
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+devices_part(struct ort *db, const struct devices *d, 
+	const struct record *rr, const struct ringdevs *rd, 
+	size_t ringsz, struct ifrecord_q *iq, 
+	struct discrecord_q *dq, int64_t id)
+{
+	struct ifrecord_q *siq;
+	struct discrecord_q *sdq;
+	size_t		 i;
+	int		 rc;
+
+	for (i = 0; i < d->sz; i++)
+		if (rr->id == d->ids[i])
+			return devices_put(iq, dq, id, 
+				d->ifs[i], d->discs[i]);
+
+	if (rr->id < 0 && (size_t)(-(rr->id + 1)) < ringsz)
+		return devices_put_ring(iq, dq, id, &rd[-(rr->id + 1)]);
+
+	siq = db_ifrecord_list_record(db, rr->id);
+	sdq = db_discrecord_list_record(db, rr->id);
+	rc = devices_put(iq, dq, id, siq, sdq);
+	db_ifrecord_freeq(siq);
+	db_discrecord_freeq(sdq);
+	return rc;
+}
+
+/*
+ * Set the per-device rows of "h", recomputed by rollup() given the
+ * newest record "f" of the next finer interval, to the sums of those
+ * of the records it's made up of among "f" and the "sz" records "rs".
+ * The rows of "f" must already have been set if it was recomputed.
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+devices_rollup(struct ort *db, struct devices *d, 
+	const struct record *h, const struct record *f, 
+	const struct record *const *rs, size_t sz, 
+	const struct ringdevs *rd, size_t ringsz)
+{
+	struct ifrecord_q *iq;
+	struct discrecord_q *dq;
+	size_t		 i;
+
+	iq = malloc(sizeof(struct ifrecord_q));
+	dq = malloc(sizeof(struct discrecord_q));
+	if (NULL != iq)
+		TAILQ_INIT(iq);
+	if (NULL != dq)
+		TAILQ_INIT(dq);
+	if (NULL == iq || NULL == dq)
+		goto out;
+
+	if (f->ctime >= h->ctime && ! devices_part
+	    (db, d, f, rd, ringsz, iq, dq, h->id))
+		goto out;
+	for (i = 0; i < sz; i++)
+		if (rollup_part(h, f, rs[i]) && ! devices_part
+		    (db, d, rs[i], rd, ringsz, iq, dq, h->id))
+			goto out;
+
+	devices_set(d, h->id, iq, dq);
+	return 1;
+out:
+	db_ifrecord_freeq(iq);
+	db_discrecord_freeq(dq);
+	return 0;
+}
+
+/*
+ * In rollup mode, the collector doesn't write the newest minute to
+ * year records until they're complete, so recompute them from the
+ * database records "q" and those of the ring file "ring", if not NULL,
+ * with its rows "rd".
+ * Those kept in the ring file are always current, so they're left be.
+ * If "d" is not NULL, also recompute the per-device rows in it, which
+ * the collector wrote with the first sample.
+ */
+static void
+rollup_get(struct kreq *r, struct record_q *q, struct record *ring, 
+	const struct ringdevs *rd, size_t ringsz, struct devices *d)
+{
+	struct record	*rr, *heads[ROLLUP_IVALS];
+	const struct record **rs;
+	size_t		 i, sz = 0, first = 1;
+
+	memset(heads, 0, sizeof(heads));
+
+	TAILQ_FOREACH(rr, q, _entries)
+		sz++;
+	rs = reallocarray(NULL, sz + ringsz + 1, sizeof(struct record *));
+	if (NULL == rs) {
+		kutil_warn(r, NULL, NULL);
+		return;
+	}
+
+	sz = 0;
+	TAILQ_FOREACH(rr, q, _entries)
+		if (NULL == ring || ! ring_has(rr->interval)) {
+			rollup_newest(heads, rr);
+			rs[sz++] = rr;
+		}
+	for (i = 0; i < ringsz; i++) {
+		rollup_newest(heads, &ring[i]);
+		rs[sz++] = &ring[i];
+	}
+
+	while (NULL != ring && first < ROLLUP_IVALS && ring_has(first))
+		first++;
+	rollup(heads, first, rs, sz);
+
+	for (i = first; NULL != d && i < ROLLUP_IVALS; i++)
+		if (NULL != heads[i] && NULL != heads[i - 1] &&
+		    ! devices_rollup(r->arg, d, heads[i], 
+		     heads[i - 1], rs, sz, rd, ringsz)) {
+			kutil_warn(r, NULL, NULL);
+			break;
+		}
+
+	free(rs);
+}
+
+static void
+devices_free(struct devices *d)
+{
+	size_t	 i;
+
+	for (i = 0; i < d->sz; i++) {
+		db_ifrecord_freeq(d->ifs[i]);
+		db_discrecord_freeq(d->discs[i]);
+	}
+}
+
+static const char *const summets[SUMMET__MAX] = {
+	"cpu", /* SUMMET_CPU */
+	"mem", /* SUMMET_MEM */
+	"nettx", /* SUMMET_NETTX */
+	"netrx", /* SUMMET_NETRX */
+	"discread", /* SUMMET_DISCREAD */
+	"discwrite", /* SUMMET_DISCWRITE */
+	"nprocs", /* SUMMET_NPROCS */
+	"rprocs", /* SUMMET_RPROCS */
+	"nfiles", /* SUMMET_NFILES */
+	"nettxpkt", /* SUMMET_NETTXPKT */
+	"netrxpkt", /* SUMMET_NETRXPKT */
+	"nettxerr", /* SUMMET_NETTXERR */
+	"netrxerr", /* SUMMET_NETRXERR */
+	"netcoll", /* SUMMET_NETCOLL */
+	"disciops", /* SUMMET_DISCIOPS */
+	"discawait", /* SUMMET_DISCAWAIT */
+	"discbusy", /* SUMMET_DISCBUSY */
+	"ctxt", /* SUMMET_CTXT */
+	"intr", /* SUMMET_INTR */
+	"procsrun", /* SUMMET_PROCSRUN */
+	"procsblk", /* SUMMET_PROCSBLK */
+	"load1", /* SUMMET_LOAD1 */
+	"load5", /* SUMMET_LOAD5 */
+	"load15", /* SUMMET_LOAD15 */
+	"psicpusome", /* SUMMET_PSICPUSOME */
+	"psicpufull", /* SUMMET_PSICPUFULL */
+	"psimemsome", /* SUMMET_PSIMEMSOME */
+	"psimemfull", /* SUMMET_PSIMEMFULL */
+	"psiiosome", /* SUMMET_PSIIOSOME */
+	"psiiofull", /* SUMMET_PSIIOFULL */
+};
+
+/*
+ * Send the record's fields followed by its decoded summary as "stats",
+ * which is null if it has none (or it's unreadable).
+ * Metrics without samples have only their zero "count".
+ */
+static void
+sendrecord(struct kjsonreq *req, const struct record *rec)
+{
+	struct summary	 s;
+	const struct sumstat *st;
+	size_t		 i;
+
+	json_record_data(req, rec);
+
+	if ( ! rec->has_summary ||
+	    ! summary_decode(&s, rec->summary, rec->summary_sz)) {
+		kjson_putnullp(req, "stats");
+		return;
+	}
+
+	kjson_objp_open(req, "stats");
+	for (i = 0; i < SUMMET__MAX; i++) {
+		st = &s.stats[i];
+		kjson_objp_open(req, summets[i]);
+		kjson_putintp(req, "count", st->count);
+		if (st->count) {
+			kjson_putdoublep(req, "min", st->min);
+			kjson_putdoublep(req, "max", st->max);
+			kjson_putdoublep(req, "p50", 
+				summary_quantile(&s, i, 0.50));
+			kjson_putdoublep(req, "p95", 
+				summary_quantile(&s, i, 0.95));
+			kjson_putdoublep(req, "p99", 
+				summary_quantile(&s, i, 0.99));
+		}
+		kjson_obj_close(req);
+	}
+	kjson_obj_close(req);
+}
+
+/*
+ * Send the array "name" of records of "ival", newest first.
+ * These are from the ring file records "ring", if not NULL and it
+ * keeps the interval, else from the database records "q".
+ */
+static void
+sendrecords(struct kjsonreq *req, const char *name, 
+	enum interval ival, const struct record_q *q,
+	const struct record *ring, size_t ringsz)
+{
+	const struct record *rr;
+	size_t		 i;
+
+	kjson_arrayp_open(req, name);
+	if (NULL != ring && ring_has(ival)) {
+		for (i = ringsz; i > 0; i--)
+			if (ival == ring[i - 1].interval) {
+				kjson_obj_open(req);
+				sendrecord(req, &ring[i - 1]);
+				kjson_obj_close(req);
+			}
+	} else if (NULL != q) {
+		TAILQ_FOREACH(rr, q, _entries)
+			if (ival == rr->interval) {
+				kjson_obj_open(req);
+				sendrecord(req, rr);
+				kjson_obj_close(req);
+			}
+	}
+	kjson_array_close(req);
+}
+
+static void
+sendindex(struct kreq *r, const struct system *sys, 
+	const struct record_q *q, const struct record *ring, 
+	size_t ringsz, const struct metric_q *mq, 
+	const struct devices *d, const struct stage_q *sq)
+{
+	struct kjsonreq	 req;
+	const struct metric *m;
+	const struct stage *s;
+	const struct ifrecord *ir;
+	const struct discrecord *dr;
+	size_t		 i;
 
 	http_open(r, KHTTP_200);
 	kjson_open(&req, r);
@@ -77,52 +587,113 @@ sendindex(struct kreq *r,
 
 	json_system_obj(&req, sys);
 
-	kjson_arrayp_open(&req, "qmin");
-	TAILQ_FOREACH(rr, q, _entries)
-		if (INTERVAL_byqmin == rr->interval) {
-			kjson_obj_open(&req);
-			json_record_data(&req, rr);
-			kjson_obj_close(&req);
-		}
-	kjson_array_close(&req);
-	kjson_arrayp_open(&req, "min");
-	TAILQ_FOREACH(rr, q, _entries)
-		if (INTERVAL_bymin == rr->interval) {
-			kjson_obj_open(&req);
-			json_record_data(&req, rr);
-			kjson_obj_close(&req);
-		}
-	kjson_array_close(&req);
-	kjson_arrayp_open(&req, "hour");
-	TAILQ_FOREACH(rr, q, _entries)
-		if (INTERVAL_byhour == rr->interval) {
-			kjson_obj_open(&req);
-			json_record_data(&req, rr);
-			kjson_obj_close(&req);
-		}
-	kjson_array_close(&req);
-	kjson_arrayp_open(&req, "day");
-	TAILQ_FOREACH(rr, q, _entries)
-		if (INTERVAL_byday == rr->interval) {
-			kjson_obj_open(&req);
-			json_record_data(&req, rr);
-			kjson_obj_close(&req);
-		}
-	kjson_array_close(&req);
-	kjson_arrayp_open(&req, "week");
-	TAILQ_FOREACH(rr, q, _entries)
-		if (INTERVAL_byweek == rr->interval) {
+	/* Older clients reject nodes they don't know. */
+
+	if (NULL != r->fieldmap[KEY_SEC])
+		sendrecords(&req, "sec", 
+			INTERVAL_bysec, q, ring, ringsz);
+	sendrecords(&req, "qmin", INTERVAL_byqmin, q, ring, ringsz);
+	sendrecords(&req, "min", INTERVAL_bymin, q, ring, ringsz);
+	sendrecords(&req, "hour", INTERVAL_byhour, q, ring, ringsz);
+	sendrecords(&req, "day", INTERVAL_byday, q, ring, ringsz);
+	sendrecords(&req, "week", INTERVAL_byweek, q, ring, ringsz);
+	sendrecords(&req, "year", INTERVAL_byyear, q, ring, ringsz);
+
+	/* Names of the identifiers in each record's metrics. */
+
+	if (NULL != r->fieldmap[KEY_METRICS]) {
+		kjson_arrayp_open(&req, "metrics");
+		if (NULL != mq)
+			TAILQ_FOREACH(m, mq, _entries) {
+				kjson_obj_open(&req);
+				json_metric_data(&req, m);
+				kjson_obj_close(&req);
+			}
+		kjson_array_close(&req);
+	}
+
+	/* Per-device rows only if asked for. */
+
+	if (NULL != d) {
+		kjson_arrayp_open(&req, "ifs");
+		for (i = 0; i < d->sz; i++)
+			if (NULL != d->ifs[i])
+				TAILQ_FOREACH(ir, d->ifs[i], _entries) {
+					kjson_obj_open(&req);
+					json_ifrecord_data(&req, ir);
+					kjson_obj_close(&req);
+				}
+		kjson_array_close(&req);
+		kjson_arrayp_open(&req, "discs");
+		for (i = 0; i < d->sz; i++)
+			if (NULL != d->discs[i])
+				TAILQ_FOREACH(dr, d->discs[i], _entries) {
+					kjson_obj_open(&req);
+					json_discrecord_data(&req, dr);
+					kjson_obj_close(&req);
+				}
+		kjson_array_close(&req);
+	}
+
+	/* The collector's own timings only if asked for. */
+
+	if (NULL != sq) {
+		kjson_arrayp_open(&req, "stages");
+		TAILQ_FOREACH(s, sq, _entries) {
 			kjson_obj_open(&req);
-			json_record_data(&req, rr);
+			json_stage_data(&req, s);
 			kjson_obj_close(&req);
 		}
-	kjson_array_close(&req);
-	kjson_arrayp_open(&req, "year");
-	TAILQ_FOREACH(rr, q, _entries)
-		if (INTERVAL_byyear == rr->interval) {
-			kjson_obj_open(&req);
-			json_record_data(&req, rr);
-			kjson_obj_close(&req);
+		kjson_array_close(&req);
+	}
+
+	kjson_obj_close(&req);
+	kjson_close(&req);
+}
+
+/*
+ * Send the records of interval "iv" packed into the chunks "q" that
+ * started from "since" to "until", oldest first.
+ */
+static void
+sendhistory(struct kreq *r, const struct system *sys, 
+	const struct ivaldef *iv, const struct chunk_q *q, 
+	time_t since, time_t until)
+{
+	struct kjsonreq	 req;
+	const struct chunk *c;
+	struct record	*rr;
+	size_t		 i, sz;
+
+	http_open(r, KHTTP_200);
+	kjson_open(&req, r);
+	kjson_obj_open(&req);
+
+	kjson_putstringp(&req, "version", VERSION);
+	kjson_putintp(&req, "timestamp", time(NULL));
+
+	json_system_obj(&req, sys);
+
+	kjson_putstringp(&req, "interval", iv->name);
+	kjson_arrayp_open(&req, "records");
+	if (NULL != q)
+		TAILQ_FOREACH(c, q, _entries) {
+			if (chunk_decode(&rr, &sz, 
+			    c->data, c->data_sz) <= 0) {
+				kutil_warnx(r, NULL, "chunk %" 
+					PRId64 ": cannot decode", c->id);
+				continue;
+			}
+			for (i = 0; i < sz; i++) {
+				if (rr[i].ctime < since || 
+				    rr[i].ctime > until)
+					continue;
+				rr[i].interval = iv->ival;
+				kjson_obj_open(&req);
+				sendrecord(&req, &rr[i]);
+				kjson_obj_close(&req);
+			}
+			free(rr);
 		}
 	kjson_array_close(&req);
 
@@ -130,13 +701,76 @@ sendindex(struct kreq *r,
 	kjson_close(&req);
 }
 
+/*
+ * Serve the history page: packed records of the "interval" from
+ * "since" (by default, one day ago) to "until" (by default, now).
+ */
+static void
+gethistory(struct kreq *r)
+{
+	const struct ivaldef *iv;
+	struct chunk_q	*q;
+	struct system	*sys;
+	time_t		 since, until;
+
+	if (NULL == r->fieldmap[KEY_INTERVAL]) {
+		http_open(r, KHTTP_400);
+		return;
+	}
+	for (iv = ivaldefs; NULL != iv->name; iv++)
+		if (0 == strcmp(iv->name, 
+		    r->fieldmap[KEY_INTERVAL]->parsed.s))
+			break;
+	if (NULL == iv->name) {
+		http_open(r, KHTTP_400);
+		return;
+	}
+
+	until = NULL != r->fieldmap[KEY_UNTIL] ?
+		r->fieldmap[KEY_UNTIL]->parsed.i : time(NULL);
+	since = NULL != r->fieldmap[KEY_SINCE] ?
+		r->fieldmap[KEY_SINCE]->parsed.i : until - 60 * 60 * 24;
+
+	db_trans_open(r->arg, 1, -1);
+	q = db_chunk_list_range(r->arg, iv->ival, since, until);
+	sys = db_system_get_id(r->arg, 1);
+	db_trans_commit(r->arg, 1);
+
+	sendhistory(r, sys, iv, q, since, until);
+
+	db_system_free(sys);
+	db_chunk_freeq(q);
+}
+
+/*
+ * Registered with sqlite3_auto_extension() to run on each connection,
+ * including that opened by db_open() in the forked database process,
+ * whose handle we otherwise never see.
+ * Without it, a reader fails outright if the collector holds its lock
+ * (as it does while committing in the default rollback-journal mode).
+ */
+static int
+busy_init(sqlite3 *db, char **er, const void *api)
+{
+
+	sqlite3_busy_timeout(db, BUSY_TIMEOUT);
+	return SQLITE_OK;
+}
+
 int
 main(void)
 {
 	struct kreq	 r;
 	enum kcgi_err	 er;
 	struct record_q	*rq;
+	struct metric_q	*mq = NULL;
+	struct stage_q	*sq = NULL;
 	struct system	*sys;
+	struct devices	 devs;
+	struct record	*ring = NULL;
+	struct ringdevs	*ringdevs = NULL;
+	size_t		 ringsz = 0;
+	int		 devices;
 
 #if HAVE_PLEDGE
 	if (-1 == pledge("stdio rpath "
@@ -147,7 +781,7 @@ main(void)
 #endif
 
 	er = khttp_parsex(&r, ksuffixmap,
-             kmimetypes, KMIME__MAX, NULL, 0,
+             kmimetypes, KMIME__MAX, keys, KEY__MAX,
              pages, PAGE__MAX, KMIME_APP_JSON,
              PAGE_INDEX, NULL, NULL, 0, NULL);
 
@@ -172,14 +806,29 @@ main(void)
 		return EXIT_SUCCESS;
 	}
 
+	if (SQLITE_OK != sqlite3_auto_extension
+	    ((void (*)(void))busy_init))
+		kutil_warnx(&r, NULL, "cannot set busy timeout");
+
 	if (NULL == (r.arg = db_open(DBFILE))) {
 		khttp_free(&r);
 		return EXIT_SUCCESS;
 	}
 
+	/* 
+	 * If the collector keeps its finest records in the ring file,
+	 * read them now, as we can't open files once pledged.
+	 * Whether it does is only known once we read the database.
+	 */
+
+	if (PAGE_INDEX == r.page && 
+	    ring_load(RINGFILE, 0, &ring, &ringdevs, &ringsz) < 0)
+		kutil_warn(&r, NULL, "%s", RINGFILE);
+
 #if HAVE_PLEDGE
 	if (-1 == pledge("stdio", NULL)) {
 		kutil_warn(NULL, NULL, "pledge");
+		free(ring);
 		db_close(r.arg);
 		khttp_free(&r);
 		return EXIT_FAILURE;
@@ -188,13 +837,50 @@ main(void)
 
 	db_role(r.arg, ROLE_consume);
 
+	if (PAGE_HISTORY == r.page) {
+		gethistory(&r);
+		db_close(r.arg);
+		khttp_free(&r);
+		return EXIT_SUCCESS;
+	}
+
+	/*
+	 * Read everything within one deferred transaction.
+	 * This gives us a consistent snapshot and, if the collector has
+	 * put the database into WAL mode, never blocks it.
+	 */
+
+	memset(&devs, 0, sizeof(struct devices));
+	devices = NULL != r.fieldmap[KEY_DEVICES];
+
+	db_trans_open(r.arg, 1, -1);
 	rq = db_record_list_lister(r.arg);
 	sys = db_system_get_id(r.arg, 1);
+	if (NULL == sys || ! sys->ring) {
+		free(ring);
+		ring = NULL;
+		ringsz = 0;
+	}
+	if (NULL != r.fieldmap[KEY_METRICS])
+		mq = db_metric_list_all(r.arg);
+	if (devices && NULL != rq)
+		devices_get(r.arg, rq, ring, ringdevs, ringsz, &devs);
+	if (NULL != sys && sys->rollup && NULL != rq)
+		rollup_get(&r, rq, ring, ringdevs, 
+			ringsz, devices ? &devs : NULL);
+	if (NULL != r.fieldmap[KEY_STAGES])
+		sq = db_stage_list_all(r.arg);
+	db_trans_commit(r.arg, 1);
 
-	sendindex(&r, sys, rq);
+	sendindex(&r, sys, rq, ring, ringsz, 
+		mq, devices ? &devs : NULL, sq);
 
+	devices_free(&devs);
+	db_stage_freeq(sq);
+	db_metric_freeq(mq);
 	db_system_free(sys);
 	db_record_freeq(rq);
+	free(ring);
 
 	db_close(r.arg);
 	khttp_free(&r);
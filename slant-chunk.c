@@ -0,0 +1,355 @@
+/*	$Id$ */
+/*
+ * Copyright (c) 2018 Kristaps Dzonsons <kristaps@bsd.lv>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include "config.h"
+
+#if HAVE_SYS_QUEUE
+# include <sys/queue.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "extern.h"
+#include "slant-chunk.h"
+
+/*
+ * Version of the encoding in chunk_encode().
+ */
+#define	CHUNK_VERSION 1
+
+/*
+ * Record fields packed into a chunk after the record times, in order.
+ * New fields must only be appended: decoders skip columns past those
+ * they know and leave the fields of columns missing in old chunks as
+ * zero.
+ */
+static	const struct chunkcol {
+	size_t		 off; /* offset in struct record */
+	int		 real; /* double (else int64_t) */
+} chunkcols[] = {
+	{ offsetof(struct record, entries), 0 },
+	{ offsetof(struct record, cpu), 1 },
+	{ offsetof(struct record, mem), 1 },
+	{ offsetof(struct record, nettx), 0 },
+	{ offsetof(struct record, netrx), 0 },
+	{ offsetof(struct record, nettxpkt), 0 },
+	{ offsetof(struct record, netrxpkt), 0 },
+	{ offsetof(struct record, nettxerr), 1 },
+	{ offsetof(struct record, netrxerr), 1 },
+	{ offsetof(struct record, netcoll), 1 },
+	{ offsetof(struct record, discread), 0 },
+	{ offsetof(struct record, discwrite), 0 },
+	{ offsetof(struct record, disciops), 0 },
+	{ offsetof(struct record, discawait), 1 },
+	{ offsetof(struct record, discbusy), 1 },
+	{ offsetof(struct record, nprocs), 1 },
+	{ offsetof(struct record, rprocs), 1 },
+	{ offsetof(struct record, nfiles), 1 },
+	{ offsetof(struct record, ctxt), 0 },
+	{ offsetof(struct record, intr), 0 },
+	{ offsetof(struct record, procsrun), 1 },
+	{ offsetof(struct record, procsblk), 1 },
+	{ offsetof(struct record, load1), 1 },
+	{ offsetof(struct record, load5), 1 },
+	{ offsetof(struct record, load15), 1 },
+	{ offsetof(struct record, psicpusome), 1 },
+	{ offsetof(struct record, psicpufull), 1 },
+	{ offsetof(struct record, psimemsome), 1 },
+	{ offsetof(struct record, psimemfull), 1 },
+	{ offsetof(struct record, psiiosome), 1 },
+	{ offsetof(struct record, psiiofull), 1 },
+};
+
+#define	CHUNK_COLS (sizeof(chunkcols) / sizeof(chunkcols[0]))
+
+/*
+ * Largest encoded value of any column: a 10-byte varint.
+ */
+#define	CHUNK_VALMAX 10
+
+static size_t
+put_varint(unsigned char *buf, uint64_t v)
+{
+	size_t	 sz = 0;
+
+	while (v >= 0x80) {
+		buf[sz++] = (v & 0x7f) | 0x80;
+		v >>= 7;
+	}
+	buf[sz++] = v;
+	return sz;
+}
+
+static int
+get_varint(const unsigned char **buf,
+	const unsigned char *end, uint64_t *v)
+{
+	unsigned int	 shift = 0;
+
+	*v = 0;
+	while (*buf < end && shift < 64) {
+		*v |= (uint64_t)(**buf & 0x7f) << shift;
+		if ( ! (*(*buf)++ & 0x80))
+			return 1;
+		shift += 7;
+	}
+	return 0;
+}
+
+/*
+ * Map signed to unsigned so that small magnitudes have short varints.
+ */
+static uint64_t
+zigzag(int64_t v)
+{
+
+	return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t
+unzigzag(uint64_t v)
+{
+
+	return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+/*
+ * Write the XOR "x" of a double with the previous one: a zero byte if
+ * they're the same, else one plus eight times the number of leading
+ * zero bytes plus the number of trailing zero bytes, then the bytes
+ * between them, least significant first.
+ */
+static size_t
+put_xor(unsigned char *buf, uint64_t x)
+{
+	size_t	 lead = 0, trail = 0, sz = 0, i;
+
+	if (0 == x) {
+		buf[sz++] = 0;
+		return sz;
+	}
+	while (0 == (x >> (56 - lead * 8) & 0xff))
+		lead++;
+	while (0 == (x >> (trail * 8) & 0xff))
+		trail++;
+	buf[sz++] = 1 + lead * 8 + trail;
+	for (i = trail; i < 8 - lead; i++)
+		buf[sz++] = x >> (i * 8);
+	return sz;
+}
+
+static int
+get_xor(const unsigned char **buf,
+	const unsigned char *end, uint64_t *x)
+{
+	size_t	 lead, trail, i;
+	unsigned int h;
+
+	*x = 0;
+	if (*buf == end)
+		return 0;
+	if (0 == (h = *(*buf)++))
+		return 1;
+	h--;
+	lead = h / 8;
+	trail = h % 8;
+	if (h >= 64 || lead + trail >= 8 ||
+	    (size_t)(end - *buf) < 8 - lead - trail)
+		return 0;
+	for (i = trail; i < 8 - lead; i++)
+		*x |= (uint64_t)*(*buf)++ << (i * 8);
+	return 1;
+}
+
+/*
+ * Pack column "col" (or the record times if CHUNK_COLS) of the "sz"
+ * records "r" into "buf".
+ * Times are delta-of-delta encoded, integers are deltas, and reals are
+ * XORed with the previous value.
+ * Returns the number of bytes written.
+ */
+static size_t
+chunk_col_encode(unsigned char *buf,
+	const struct record *r, size_t sz, size_t col)
+{
+	const struct chunkcol *c = &chunkcols[col];
+	const char	*p;
+	size_t		 i, pos = 0;
+	int64_t		 v, prev = 0, d, prevd = 0;
+	uint64_t	 bits, prevbits = 0;
+	double		 dv;
+
+	for (i = 0; i < sz; i++) {
+		if (CHUNK_COLS == col) {
+			d = r[i].ctime - prev;
+			pos += put_varint(buf + pos, zigzag(d - prevd));
+			prev = r[i].ctime;
+			prevd = i > 0 ? d : 0;
+			continue;
+		}
+		p = (const char *)&r[i] + c->off;
+		if (c->real) {
+			memcpy(&dv, p, sizeof(double));
+			memcpy(&bits, &dv, sizeof(double));
+			pos += put_xor(buf + pos, bits ^ prevbits);
+			prevbits = bits;
+		} else {
+			memcpy(&v, p, sizeof(int64_t));
+			pos += put_varint(buf + pos, zigzag(v - prev));
+			prev = v;
+		}
+	}
+	return pos;
+}
+
+/*
+ * Unpack column "col" (or the record times if CHUNK_COLS) of the "sz"
+ * records "r" from all of "buf" to "end".
+ * Returns zero if malformed, non-zero on success.
+ */
+static int
+chunk_col_decode(struct record *r, size_t sz, size_t col,
+	const unsigned char *buf, const unsigned char *end)
+{
+	const struct chunkcol *c = &chunkcols[col];
+	char		*p;
+	size_t		 i;
+	int64_t		 v, prev = 0, d, prevd = 0;
+	uint64_t	 u, bits = 0;
+	double		 dv;
+
+	for (i = 0; i < sz; i++) {
+		if (CHUNK_COLS == col) {
+			if ( ! get_varint(&buf, end, &u))
+				return 0;
+			d = unzigzag(u) + prevd;
+			r[i].ctime = prev + d;
+			prev = r[i].ctime;
+			prevd = i > 0 ? d : 0;
+			continue;
+		}
+		p = (char *)&r[i] + c->off;
+		if (c->real) {
+			if ( ! get_xor(&buf, end, &u))
+				return 0;
+			bits ^= u;
+			memcpy(&dv, &bits, sizeof(double));
+			memcpy(p, &dv, sizeof(double));
+		} else {
+			if ( ! get_varint(&buf, end, &u))
+				return 0;
+			v = prev + unzigzag(u);
+			memcpy(p, &v, sizeof(int64_t));
+			prev = v;
+		}
+	}
+	return buf == end;
+}
+
+/*
+ * Pack the "sz" records "r", oldest first, into a chunk.
+ * This is the version byte, the number of records, and the number of
+ * columns (the record times, then those in "chunkcols").
+ * Each column follows as its length in bytes and its values.
+ * Integers are unsigned LEB128, with signed values zigzag mapped.
+ * Only the values are packed: summaries, cores, and metrics are not.
+ * Returns the buffer of size "bsz" or NULL on memory exhaustion.
+ */
+void *
+chunk_encode(const struct record *r, size_t sz, size_t *bsz)
+{
+	unsigned char	*buf, *col;
+	size_t		 i, pos = 0, csz;
+
+	col = reallocarray(NULL, sz + 1, CHUNK_VALMAX);
+	buf = reallocarray(NULL, sz + 2, (CHUNK_COLS + 1) * CHUNK_VALMAX);
+	if (NULL == col || NULL == buf) {
+		free(col);
+		free(buf);
+		return NULL;
+	}
+
+	buf[pos++] = CHUNK_VERSION;
+	pos += put_varint(buf + pos, sz);
+	pos += put_varint(buf + pos, CHUNK_COLS + 1);
+
+	csz = chunk_col_encode(col, r, sz, CHUNK_COLS);
+	pos += put_varint(buf + pos, csz);
+	memcpy(buf + pos, col, csz);
+	pos += csz;
+
+	for (i = 0; i < CHUNK_COLS; i++) {
+		csz = chunk_col_encode(col, r, sz, i);
+		pos += put_varint(buf + pos, csz);
+		memcpy(buf + pos, col, csz);
+		pos += csz;
+	}
+
+	free(col);
+	*bsz = pos;
+	return buf;
+}
+
+/*
+ * Unpack a chunk made by chunk_encode() into "rp", of size "sz", to be
+ * freed by the caller.
+ * Fields other than those packed are zero.
+ * Returns <0 on memory exhaustion, 0 if malformed or of another
+ * version, >0 on success.
+ */
+int
+chunk_decode(struct record **rp, size_t *sz, const void *p, size_t psz)
+{
+	const unsigned char	*buf = p, *end = buf + psz;
+	struct record		*r;
+	uint64_t		 n, cols, len, i;
+
+	*rp = NULL;
+	*sz = 0;
+
+	if (0 == psz || CHUNK_VERSION != *buf++ ||
+	    ! get_varint(&buf, end, &n) ||
+	    ! get_varint(&buf, end, &cols) ||
+	    0 == cols || n > psz)
+		return 0;
+	if (0 == n)
+		return 1;
+	if (NULL == (r = calloc(n, sizeof(struct record))))
+		return -1;
+
+	for (i = 0; i < cols; i++) {
+		if ( ! get_varint(&buf, end, &len) ||
+		    len > (uint64_t)(end - buf))
+			break;
+		if (i <= CHUNK_COLS && ! chunk_col_decode(r, n,
+		    0 == i ? CHUNK_COLS : i - 1, buf, buf + len))
+			break;
+		buf += len;
+	}
+
+	if (i < cols || buf != end) {
+		free(r);
+		return 0;
+	}
+
+	*rp = r;
+	*sz = n;
+	return 1;
+}
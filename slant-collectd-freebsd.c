@@ -243,6 +243,196 @@ sysinfo_get_boottime(const struct sysinfo *p)
 	return p->boottime;
 }
 
+/*
+ * Sources aren't sampled separately here, so none is ever stale.
+ */
+int
+sysinfo_get_stale(const struct sysinfo *p, enum sysrc src)
+{
+
+	return 0;
+}
+
+/*
+ * Processing units aren't broken down here.
+ */
+size_t
+sysinfo_get_cores(const struct sysinfo *p, const uint16_t **v)
+{
+
+	*v = NULL;
+	return 0;
+}
+
+/*
+ * Interfaces and discs aren't broken down here.
+ */
+size_t
+sysinfo_get_ifs(const struct sysinfo *p, const struct sysdev **v)
+{
+
+	*v = NULL;
+	return 0;
+}
+
+size_t
+sysinfo_get_discs(const struct sysinfo *p, const struct sysdev **v)
+{
+
+	*v = NULL;
+	return 0;
+}
+
+/*
+ * Only bytes are counted on interfaces here.
+ */
+int64_t
+sysinfo_get_nettxpkt_avg(const struct sysinfo *p)
+{
+
+	return 0;
+}
+
+int64_t
+sysinfo_get_netrxpkt_avg(const struct sysinfo *p)
+{
+
+	return 0;
+}
+
+double
+sysinfo_get_nettxerr_avg(const struct sysinfo *p)
+{
+
+	return 0.0;
+}
+
+double
+sysinfo_get_netrxerr_avg(const struct sysinfo *p)
+{
+
+	return 0.0;
+}
+
+double
+sysinfo_get_netcoll_avg(const struct sysinfo *p)
+{
+
+	return 0.0;
+}
+
+/*
+ * Disc operations and latency aren't accounted here.
+ */
+int64_t
+sysinfo_get_disciops_avg(const struct sysinfo *p)
+{
+
+	return 0;
+}
+
+double
+sysinfo_get_discawait_avg(const struct sysinfo *p)
+{
+
+	return 0.0;
+}
+
+double
+sysinfo_get_discbusy_avg(const struct sysinfo *p)
+{
+
+	return 0.0;
+}
+
+/*
+ * Context switches, interrupts, the run queue, and load averages
+ * aren't collected here, and there's no pressure stall information.
+ */
+int64_t
+sysinfo_get_ctxt_avg(const struct sysinfo *p)
+{
+
+	return 0;
+}
+
+int64_t
+sysinfo_get_intr_avg(const struct sysinfo *p)
+{
+
+	return 0;
+}
+
+double
+sysinfo_get_procsrun(const struct sysinfo *p)
+{
+
+	return 0.0;
+}
+
+double
+sysinfo_get_procsblk(const struct sysinfo *p)
+{
+
+	return 0.0;
+}
+
+double
+sysinfo_get_load1(const struct sysinfo *p)
+{
+
+	return 0.0;
+}
+
+double
+sysinfo_get_load5(const struct sysinfo *p)
+{
+
+	return 0.0;
+}
+
+double
+sysinfo_get_load15(const struct sysinfo *p)
+{
+
+	return 0.0;
+}
+
+double
+sysinfo_get_psi_some(const struct sysinfo *p, enum psirc r)
+{
+
+	return 0.0;
+}
+
+double
+sysinfo_get_psi_full(const struct sysinfo *p, enum psirc r)
+{
+
+	return 0.0;
+}
+
+/*
+ * There are no metrics beyond the record's own fields.
+ */
+size_t
+sysinfo_get_metrics(const struct sysinfo *p, const struct sysmetric **v)
+{
+
+	*v = NULL;
+	return 0;
+}
+
+/*
+ * Sources aren't timed separately here.
+ */
+double
+sysinfo_get_took(const struct sysinfo *p, enum sysrc src)
+{
+
+	return -1.0;
+}
+
 void
 sysinfo_free(struct sysinfo *p)
 {
@@ -55,9 +55,15 @@
 #include "config.h"
 
 #include <net/if.h>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 
 #include <sys/ioctl.h>
 #include <sys/queue.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
@@ -65,6 +71,7 @@
 #include <ctype.h>
 #include <dirent.h>
 #include <err.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
 #include <limits.h>
@@ -73,68 +80,225 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "slant-collectd.h"
+#include "slant-proc.h"
 #include "extern.h"
 #include "db.h"
 
-/*
- * /proc/stat
- */
-#define CP_USER 0
-#define CP_NICE 1
-#define CP_SYS 2
-#define CP_IDLE 3
-#define CP_IOWAIT 4
-#define CP_IRQ 5
-#define CP_SOFTIRQ 6
-#define CP_STEAL 7
-#define CP_GUEST 8
-#define CP_GUEST_NICE 9
-#define CPUSTATES 10
-
 /*
  * Sector size is always 512
  * https://lkml.org/lkml/2015/8/17/269
  */
 #define SECTOR_SHIFT 9
 
-struct 	ifcount {
-	uint64_t	ifc_ib;			/* input bytes */
-	uint64_t	ifc_ip;			/* input packets */
-	uint64_t	ifc_ie;			/* input errors */
-	uint64_t	ifc_ob;			/* output bytes */
-	uint64_t	ifc_op;			/* output packets */
-	uint64_t	ifc_oe;			/* output errors */
-	uint64_t	ifc_co;			/* collisions */
+/*
+ * Number of buckets in the disc classification hash.
+ */
+#define DISC_HASHSZ 64
+
+/*
+ * Buckets in the hashes of monitored command names and of the
+ * processes running them.
+ */
+#define CMD_HASHSZ 32
+#define PID_HASHSZ 256
+
+/*
+ * Length of a process name in /proc/<pid>/comm, less the NUL.
+ */
+#define COMM_MAX 15
+
+/*
+ * A monitored command (-p) and how many processes are running it.
+ */
+struct	cmdent {
+	char		 name[COMM_MAX + 1]; /* truncated as in comm */
+	size_t		 nprocs; /* processes running it */
+	struct cmdent	*next; /* next in hash bucket */
+};
+
+/*
+ * A process running a monitored command.
+ */
+struct	pident {
+	pid_t		 pid; /* process (thread group) id */
+	struct cmdent	*cmd; /* command it's running */
+	struct pident	*next; /* next in hash bucket */
+};
+
+/*
+ * How many samples between re-reading pid_max, which almost never
+ * changes.
+ */
+#define PIDMAX_REFRESH 240
+
+/*
+ * How many scans of /proc/diskstats between re-classifying discs if
+ * we can't listen for devices coming and going.
+ */
+#define DISC_REFRESH 20
+
+/*
+ * Whether we sum a device in /proc/diskstats.
+ * This is computed once per name and cached until the kernel says the
+ * device has come or gone; it's dropped when no longer listed.
+ */
+struct	discent {
+	char		*name; /* name as in /proc/diskstats */
+	int		 use; /* whether to include it */
+	size_t		 scan; /* last scan listing it */
+	int		 seen; /* rbytes and wbytes are set */
+	uint64_t	 rbytes; /* last read bytes */
+	uint64_t	 wbytes; /* last written bytes */
+	uint64_t	 ios; /* last I/Os completed */
+	uint64_t	 ticks; /* last ms spent in I/Os */
+	uint64_t	 busy; /* last ms doing I/O */
+	struct discent	*next; /* next in hash bucket */
 };
 
 struct	ifstat {
 	struct ifcount	ifs_cur;
 	struct ifcount	ifs_old;
 	struct ifcount	ifs_now;
+	char		ifs_name[IFNAMSIZ]; /* last known name */
+	int		ifs_up; /* counted in the last sample */
+	int		ifs_fresh; /* ifs_now is from this dump */
+	int		ifs_seen; /* ifs_old is from this interface */
+};
+
+/*
+ * Files in /proc we read on every sample.
+ * These are opened once in sysinfo_alloc() and re-read from the start
+ * with pread(2) instead of being opened and closed each time.
+ */
+enum	procfile {
+	PROC_MEMINFO = 0,
+	PROC_STAT,
+	PROC_NETDEV,
+	PROC_DISKSTATS,
+	PROC_FILENR,
+	PROC_PIDMAX,
+	PROC_LOADAVG,
+	PROC_PSICPU, /* this and following are optional */
+	PROC_PSIMEM,
+	PROC_PSIIO,
+	PROC__MAX
+};
+
+/*
+ * An open /proc file and the buffer we read it into.
+ * The buffer grows geometrically as needed and is kept between samples,
+ * so once it has grown to fit the file we no longer allocate.
+ */
+struct	procbuf {
+	int		 fd; /* open descriptor or -1 */
+	char		*buf; /* NUL-terminated contents */
+	size_t		 bufmax; /* allocated size of buf */
+};
+
+static const char *const procfiles[PROC__MAX] = {
+	"/proc/meminfo", /* PROC_MEMINFO */
+	"/proc/stat", /* PROC_STAT */
+	"/proc/net/dev", /* PROC_NETDEV */
+	"/proc/diskstats", /* PROC_DISKSTATS */
+	"/proc/sys/fs/file-nr", /* PROC_FILENR */
+	"/proc/sys/kernel/pid_max", /* PROC_PIDMAX */
+	"/proc/loadavg", /* PROC_LOADAVG */
+	"/proc/pressure/cpu", /* PROC_PSICPU */
+	"/proc/pressure/memory", /* PROC_PSIMEM */
+	"/proc/pressure/io", /* PROC_PSIIO */
+};
+
+/*
+ * Metrics without record fields of their own.
+ * See sysinfo_get_metrics().
+ */
+enum	sysmet {
+	SYSMET_MEMAVAIL = 0,
+	SYSMET_SWAP,
+	SYSMET__MAX
+};
+
+static const char *const sysmets[SYSMET__MAX] = {
+	"memavail", /* SYSMET_MEMAVAIL */
+	"swap", /* SYSMET_SWAP */
+};
+
+/*
+ * Processor time of a single core.
+ */
+struct	corestat {
+	uint64_t	 cp_time[CPUSTATES]; /* last read */
+	uint64_t	 cp_old[CPUSTATES]; /* previously read */
+	uint64_t	 cp_diff[CPUSTATES]; /* difference */
+	uint64_t	 states[CPUSTATES]; /* permille per state */
 };
 
 struct	sysinfo {
 	size_t		 sample; /* sample number */
+	struct procbuf	 procs[PROC__MAX]; /* open /proc files */
 	double		 mem_avg; /* average memory */
 	double		 nproc_pct; /* nprocs percent */
+	uint64_t	 maxproc; /* cached pid_max */
 	double		 nfile_pct; /* nfiles percent */
 	uint64_t	 cpu_states[CPUSTATES]; /* used for cpu compute */
 	double		 cpu_avg; /* average cpu */
 	uint64_t	 cp_time[CPUSTATES]; /* used for cpu compute */
 	uint64_t         cp_old[CPUSTATES]; /* used for cpu compute */
 	uint64_t         cp_diff[CPUSTATES]; /* used for cpu compute */
+	struct corestat	*cores; /* per-core cpu compute */
+	uint16_t	*corepm; /* per-core permille busy */
+	size_t		 coresz; /* cores in last sample */
+	size_t		 coremax; /* allocated cores */
 	double		 rproc_pct; /* pct command (by name) found */
+	int		 nlfd; /* rtnetlink socket or -1 */
+	uint32_t	 nlseq; /* last rtnetlink request */
+	char		*nlbuf; /* rtnetlink receive buffer */
+	size_t		 nlbufmax; /* allocated size of nlbuf */
 	struct ifstat	*ifstats; /* used for inet compute */
 	size_t		 ifstatsz; /* used for inet compute */
 	struct ifcount	 ifsum; /* average inet */
-	u_int64_t	 disc_rbytes; /* last disc total read */
-	u_int64_t	 disc_wbytes; /* last disc total write */
+	double		 nettxerr; /* output errors/second */
+	double		 netrxerr; /* input errors/second */
+	double		 netcoll; /* collisions/second */
+	struct sysdev	*ifdevs; /* per-interface rates */
+	size_t		 ifdevsz; /* interfaces in last sample */
+	size_t		 ifdevmax; /* allocated size of ifdevs */
+	struct sysdev	*discdevs; /* per-disc rates */
+	size_t		 discdevsz; /* discs in last sample */
+	size_t		 discdevmax; /* allocated size of discdevs */
 	int64_t	 	 disc_ravg; /* average reads/sec */
 	int64_t	 	 disc_wavg; /* average reads/sec */
+	int64_t		 disc_iops; /* I/Os completed/sec */
+	double		 disc_await; /* average ms per I/O */
+	double		 disc_busy; /* busiest disc, percent */
 	time_t		 boottime; /* time booted */
+	uint64_t	 ctxt; /* last context switches */
+	uint64_t	 intr; /* last interrupts */
+	int64_t		 ctxt_avg; /* context switches/sec */
+	int64_t		 intr_avg; /* interrupts/sec */
+	uint64_t	 procs_run; /* runnable threads */
+	uint64_t	 procs_blk; /* threads blocked on I/O */
+	double		 load[3]; /* 1, 5, 15 minute load */
+	double		 psi_some[PSI__MAX]; /* some avg10 */
+	double		 psi_full[PSI__MAX]; /* full avg10 */
+	struct sysmetric metrics[SYSMET__MAX]; /* see sysinfo_get_metrics */
+	struct timespec	 last[SYSRC__MAX]; /* time of last sample */
+	int		 stale[SYSRC__MAX]; /* last sample failed */
+	double		 took[SYSRC__MAX]; /* seconds to sample or -1 */
+	double		 elapsed; /* seconds since source last sampled */
+	struct discent	*discs[DISC_HASHSZ]; /* disc classifications */
+	int		 discfd; /* kernel uevents or -1 */
+	size_t		 discscan; /* scans of /proc/diskstats */
+	int		 rproc_init; /* rprocs set up */
+	struct cmdent	*cmds[CMD_HASHSZ]; /* monitored commands */
+	size_t		 cmdsz; /* distinct monitored commands */
+	struct pident	*pids[PID_HASHSZ]; /* processes running cmds */
+	int		 cnfd; /* proc connector or -1 */
+	int		 cnresync; /* connector lost events */
 };
 
 static void
@@ -172,53 +336,277 @@ percentages(int cnt, uint64_t *out,
 		*out++ = ((*diffs++ * 1000 + half_total) / tot);
 }
 
+/*
+ * FNV-1a hash of a NUL-terminated string.
+ */
+static uint32_t
+hash_str(const char *cp)
+{
+	uint32_t	 h = 2166136261U;
+
+	for ( ; '\0' != *cp; cp++)
+		h = (h ^ (unsigned char)*cp) * 16777619U;
+	return h;
+}
+
+/*
+ * Forget all processes running monitored commands.
+ */
+static void
+pid_flush(struct sysinfo *p)
+{
+	struct pident	*pe;
+	size_t		 i;
+
+	for (i = 0; i < PID_HASHSZ; i++)
+		while (NULL != (pe = p->pids[i])) {
+			p->pids[i] = pe->next;
+			pe->cmd->nprocs--;
+			free(pe);
+		}
+}
+
+/*
+ * Clear all cached disc classifications.
+ */
+static void
+disc_flush(struct sysinfo *p)
+{
+	struct discent	*d;
+	size_t		 i;
+
+	for (i = 0; i < DISC_HASHSZ; i++)
+		while (NULL != (d = p->discs[i])) {
+			p->discs[i] = d->next;
+			free(d->name);
+			free(d);
+		}
+}
+
+/*
+ * Listen for the kernel's uevents of devices coming and going: sysfs
+ * doesn't support inotify(7).
+ * Returns -1 if this isn't possible: unknown names are still
+ * classified on first sight, and all are re-classified every
+ * DISC_REFRESH scans.
+ */
+static int
+disc_watch(void)
+{
+	struct sockaddr_nl	 sa;
+	int			 fd;
+
+	fd = socket(AF_NETLINK, SOCK_DGRAM | 
+		SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+	if (-1 == fd) {
+		warn("socket: NETLINK_KOBJECT_UEVENT");
+		return -1;
+	}
+
+	memset(&sa, 0, sizeof(struct sockaddr_nl));
+	sa.nl_family = AF_NETLINK;
+	sa.nl_groups = 1; /* kernel (not udev) events */
+
+	if (-1 == bind(fd, (struct sockaddr *)&sa, sizeof(sa))) {
+		warn("bind: NETLINK_KOBJECT_UEVENT");
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
 void
 sysinfo_free(struct sysinfo *p)
 {
+	struct cmdent	*c;
+	size_t		 i;
+
 	if (NULL == p)
 		return;
 
+	for (i = 0; i < PROC__MAX; i++) {
+		if (-1 != p->procs[i].fd)
+			close(p->procs[i].fd);
+		free(p->procs[i].buf);
+	}
+
+	if (-1 != p->nlfd)
+		close(p->nlfd);
+	free(p->nlbuf);
+	if (-1 != p->discfd)
+		close(p->discfd);
+	disc_flush(p);
+	if (-1 != p->cnfd)
+		close(p->cnfd);
+	pid_flush(p);
+	for (i = 0; i < CMD_HASHSZ; i++)
+		while (NULL != (c = p->cmds[i])) {
+			p->cmds[i] = c->next;
+			free(c);
+		}
 	free(p->ifstats);
+	free(p->ifdevs);
+	free(p->discdevs);
+	free(p->cores);
+	free(p->corepm);
 	free(p);
 }
 
+/*
+ * Open the /proc file "f" and keep its descriptor in "p".
+ * Return zero on failure, non-zero on success.
+ */
 static int
-sysinfo_init_boottime(struct sysinfo *p)
+proc_open(struct sysinfo *p, enum procfile f)
 {
-	FILE *fp;
-	char *line = NULL;
-	size_t n = 0;
-	uint64_t btime = 0;
 
-	if ((fp = fopen("/proc/stat", "r")) == NULL) {
-		warn("open: /proc/stat");
+	assert(-1 == p->procs[f].fd);
+	if (-1 == (p->procs[f].fd = open(procfiles[f], O_RDONLY))) {
+		warn("open: %s", procfiles[f]);
 		return 0;
 	}
+	return 1;
+}
 
-	while (-1 != getline(&line, &n, fp)) {
-		if (0 == strcmp("btime ", line)) {
-			if (1 != scanf(line+6, "%" SCNu64, &btime)) {
-				warnx("failed to get boot time");
-				fclose(fp);
-				free(line);
-				return 0;
+/*
+ * Read the full contents of the /proc file "f", setting "bufp" to the
+ * NUL-terminated contents.
+ * The descriptor is kept open between samples and re-read from the
+ * start: we only re-open it if the read fails, e.g., when the backing
+ * entry has gone away underneath us.
+ * Many files in /proc (those backed by seq_file) return only about a
+ * page per read no matter how much is asked for, so a short read
+ * doesn't mean we've read everything: keep reading, growing the buffer
+ * as it fills, until the end of the file.
+ * Returns the number of bytes read or -1 on failure.
+ */
+static ssize_t
+proc_read_buf(struct sysinfo *p, enum procfile f, char **bufp)
+{
+	struct procbuf	*pb = &p->procs[f];
+	ssize_t		 rd;
+	size_t		 off = 0, want, newmax;
+	char		*pp;
+	int		 reopened = 0;
+
+again:
+	if (-1 == pb->fd && ! proc_open(p, f))
+		return -1;
+
+	for (;;) {
+		if (pb->bufmax - off < 2) {
+			newmax = 0 == pb->bufmax ?
+				8192 : pb->bufmax * 2;
+			if (NULL == (pp = realloc(pb->buf, newmax))) {
+				warn(NULL);
+				return -1;
 			}
-			break;
+			pb->buf = pp;
+			pb->bufmax = newmax;
+		}
+		want = pb->bufmax - off - 1;
+		rd = pread(pb->fd, pb->buf + off, want, off);
+		if (-1 == rd) {
+			close(pb->fd);
+			pb->fd = -1;
+			if ( ! reopened) {
+				reopened = 1;
+				off = 0;
+				goto again;
+			}
+			warn("pread: %s", procfiles[f]);
+			return -1;
 		}
+		if (0 == rd)
+			break;
+		off += rd;
 	}
 
-	fclose(fp);
-	free(line);
+	pb->buf[off] = '\0';
+	*bufp = pb->buf;
+#ifdef DEBUG
+	warnx("%s: read %zu bytes", procfiles[f], off);
+#endif
+	return off;
+}
 
-	p->boottime = btime;
+/*
+ * Convert a counter difference into a per-second rate over the time
+ * since the current source was last sampled.
+ */
+static uint64_t
+rate(const struct sysinfo *p, uint64_t delta)
+{
+
+	return p->elapsed > 0.0 ? delta / p->elapsed : 0;
+}
+
+/*
+ * Like rate(), but keeping the fraction for rare events like errors.
+ */
+static double
+rate_real(const struct sysinfo *p, uint64_t delta)
+{
+
+	return p->elapsed > 0.0 ? delta / p->elapsed : 0.0;
+}
+
+static int
+sysinfo_init_boottime(struct sysinfo *p)
+{
+	ssize_t	 rd;
+	char	*buf, *cp;
+	uint64_t btime;
+
+	if (-1 == (rd = proc_read_buf(p, PROC_STAT, &buf)))
+		return 0;
+
+	cp = memmem(buf, rd, "\nbtime ", 7);
+	if (NULL == cp || (cp += 7, ! tok_u64(&cp, buf + rd, &btime))) {
+		warnx("failed to get boot time");
+		return 0;
+	}
 
+	p->boottime = btime;
 	return 1;
 }
 
+/*
+ * Open the rtnetlink socket used for interface statistics.
+ * Returns -1 if the socket can't be created: we'll then use the
+ * /proc/net/dev and ioctl(2) fallback.
+ */
+static int
+nl_open(void)
+{
+	struct sockaddr_nl	 sa;
+	int			 fd;
+
+	fd = socket(AF_NETLINK, 
+		SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+	if (-1 == fd) {
+		warn("socket: NETLINK_ROUTE");
+		return -1;
+	}
+
+	memset(&sa, 0, sizeof(struct sockaddr_nl));
+	sa.nl_family = AF_NETLINK;
+
+	if (-1 == bind(fd, (struct sockaddr *)&sa, sizeof(sa))) {
+		warn("bind: NETLINK_ROUTE");
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
 struct sysinfo *
 sysinfo_alloc(void)
 {
 	struct sysinfo	*p;
+	size_t		 i;
 
 	p = calloc(1, sizeof(struct sysinfo));
 	if (NULL == p) {
@@ -226,6 +614,26 @@ sysinfo_alloc(void)
 		return NULL;
 	}
 
+	for (i = 0; i < PROC__MAX; i++)
+		p->procs[i].fd = -1;
+	for (i = 0; i < SYSMET__MAX; i++)
+		p->metrics[i].name = sysmets[i];
+
+	p->nlfd = nl_open();
+	p->discfd = disc_watch();
+	p->cnfd = -1;
+
+	for (i = 0; i < PROC_PSICPU; i++)
+		if ( ! proc_open(p, i)) {
+			sysinfo_free(p);
+			return NULL;
+		}
+
+	/* Pressure stall information needs CONFIG_PSI. */
+
+	for ( ; i < PROC__MAX; i++)
+		p->procs[i].fd = open(procfiles[i], O_RDONLY);
+
 	if ( ! sysinfo_init_boottime(p)) {
 		sysinfo_free(p);
 		return NULL;
@@ -234,61 +642,65 @@ sysinfo_alloc(void)
 	return p;
 }
 
-static char buf[8192];
-
-static ssize_t
-proc_read_buf(const char *file)
+/*
+ * Read the pressure stall averages from "f", if we have it.
+ * This never fails: if the file can't be read or parsed, we stop using
+ * it and report zero.
+ */
+static void
+sysinfo_update_psi(struct sysinfo *p, enum procfile f)
 {
-	int fd;
-	ssize_t rd;
-	if (-1 == (fd = open(file, O_RDONLY))) {
-		warn("open: %s", file);
-		return -1;
-	}
-	if (-1 == (rd = read(fd, buf, sizeof buf - 1))) {
-		warn("read: %s", file);
-		close(fd);
-		return -1;
-	}
-	close(fd);
-	buf[rd] = '\0';
-#ifdef DEBUG
-	warnx("%s: read %ld bytes", file, rd);
-#endif
-	return rd;
+	size_t	 i = f - PROC_PSICPU;
+	ssize_t	 rd;
+	char	*buf;
+
+	assert(i < PSI__MAX);
+	if (-1 == p->procs[f].fd)
+		return;
+
+	rd = proc_read_buf(p, f, &buf);
+	if (-1 != rd && 
+	    parse_psi(buf, rd, &p->psi_some[i], &p->psi_full[i]))
+		return;
+
+	if (-1 != rd)
+		warnx("error while parsing %s", procfiles[f]);
+	if (-1 != p->procs[f].fd)
+		close(p->procs[f].fd);
+	p->procs[f].fd = -1;
+	p->psi_some[i] = p->psi_full[i] = 0.0;
 }
 
 static int
 sysinfo_update_mem(struct sysinfo *p)
 {
 	ssize_t rd;
-	uint64_t memtotal, memfree;
-	char *ptr;
+	struct meminfo mi;
+	char *buf;
 
-	rd = proc_read_buf("/proc/meminfo");
+	rd = proc_read_buf(p, PROC_MEMINFO, &buf);
 	if (-1 == rd)
 		return 0;
 
-	if (NULL == (ptr = memmem(buf, rd, "MemTotal:", 9)))
-		goto errparse;
-	if (1 != sscanf(ptr+9, "%" SCNu64, &memtotal))
-		goto errparse;
-
-	if (NULL == (ptr = memmem(buf, rd, "MemFree:", 8)))
-		goto errparse;
-	if (1 != sscanf(ptr+8, "%" SCNu64, &memfree))
-		goto errparse;
+	if ( ! parse_meminfo(buf, rd, &mi) || 0 == mi.total) {
+		warnx("error while parsing /proc/meminfo");
+		return 0;
+	}
 
-	p->mem_avg = 100.0 * (memtotal - memfree) / memtotal;
+	p->mem_avg = 100.0 * (mi.total - mi.free) / mi.total;
+	p->metrics[SYSMET_MEMAVAIL].value = 
+		100.0 * mi.avail / mi.total;
+	p->metrics[SYSMET_SWAP].value = 
+		0 == mi.swaptotal || mi.swapfree > mi.swaptotal ? 0.0 :
+		100.0 * (mi.swaptotal - mi.swapfree) / mi.swaptotal;
+	sysinfo_update_psi(p, PROC_PSIMEM);
 
 #ifdef DEBUG
-	warnx("memtotal=%ld memfree=%ld mem_avg=%lf", memtotal, memfree, p->mem_avg);
+	warnx("memtotal=%" PRIu64 " memfree=%" PRIu64 " mem_avg=%lf", 
+		mi.total, mi.free, p->mem_avg);
 #endif
 
 	return 1;
-errparse:
-	warnx("error while parsing /proc/meminfo");
-	return 0;
 }
 
 static int
@@ -296,13 +708,16 @@ sysinfo_update_nfiles(const struct syscfg *cfg, struct sysinfo *p)
 {
 	uint64_t	allocfiles, unusedfiles, maxfiles;
 	ssize_t		rd;
+	char		*buf;
 
-	rd = proc_read_buf("/proc/sys/fs/file-nr");
+	rd = proc_read_buf(p, PROC_FILENR, &buf);
 	if (-1 == rd)
 		return 0;
 
-	if (3 != sscanf(buf, "%" SCNu64 " %" SCNu64 " %" SCNu64,
-	    &allocfiles, &unusedfiles, &maxfiles)) {
+	if ( ! tok_u64(&buf, buf + rd, &allocfiles) ||
+	    ! tok_u64(&buf, buf + rd, &unusedfiles) ||
+	    ! tok_u64(&buf, buf + rd, &maxfiles) ||
+	    0 == maxfiles) {
 		warnx("failed to parse /proc/sys/fs/file-nr");
 		return 0;
 	}
@@ -315,116 +730,596 @@ sysinfo_update_nfiles(const struct syscfg *cfg, struct sysinfo *p)
 	return 1;
 }
 
-static int
-sysinfo_update_nprocs(const struct syscfg *cfg, struct sysinfo *p)
+/*
+ * Count the entries of "dir" named by a number, i.e., processes in
+ * /proc or the tasks of one of them.
+ * Returns -1 if the directory can't be opened.
+ */
+static int64_t
+nprocs_count(const char *dir)
 {
 	struct dirent	*dent;
-	DIR 		*dir;
-	uint64_t	 maxproc, nprocs = 0;
-	ssize_t		 rd;
+	DIR 		*dp;
+	int64_t		 n = 0;
 
-	rd = proc_read_buf("/proc/sys/kernel/pid_max");
-	if (-1 == rd)
-		return 0;
+	if (NULL == (dp = opendir(dir)))
+		return -1;
+	while (NULL != (dent = readdir(dp)))
+		if (isdigit((unsigned char)*dent->d_name))
+			n++;
+	closedir(dp);
+	return n;
+}
 
-	if (1 != sscanf(buf, "%" SCNu64, &maxproc)) {
-		warnx("error while parsing /proc/sys/kernel/pid_max");
-		return 0;
-	}
+/*
+ * Validate the task count from /proc/loadavg by walking the tasks of
+ * each process in /proc, warning if they differ by more than a tenth.
+ * This is far too expensive for regular use on busy hosts and races
+ * tasks coming and going, so it's only done with -V.
+ */
+static void
+nprocs_validate(uint64_t nprocs)
+{
+	struct dirent	*dent;
+	DIR 		*dir;
+	char		 path[PATH_MAX];
+	int64_t		 n;
+	uint64_t	 walked = 0;
 
-	dir = opendir("/proc");
-	if (NULL == dir) {
+	if (NULL == (dir = opendir("/proc"))) {
 		warn("opendir: /proc");
-		return 0;
+		return;
 	}
-
 	while (NULL != (dent = readdir(dir))) {
-		if (isdigit(*dent->d_name))
-			nprocs++;
+		if ( ! isdigit((unsigned char)*dent->d_name))
+			continue;
+		snprintf(path, sizeof(path), 
+			"/proc/%s/task", dent->d_name);
+		if ((n = nprocs_count(path)) > 0)
+			walked += n;
 	}
 	closedir(dir);
 
-#ifdef DEBUG
-	warnx("procs: nprocs=%" PRIu64 " maxproc=%" PRIu64, nprocs, maxproc);
-#endif
+	if ((walked > nprocs ? walked - nprocs : nprocs - walked) > 
+	    nprocs / 10)
+		warnx("procs: loadavg has %" PRIu64 " tasks, "
+			"/proc has %" PRIu64, nprocs, walked);
+}
 
-	p->nproc_pct = 100.0 * nprocs / (double)maxproc;
+/*
+ * Find the monitored command matching a process name.
+ */
+static struct cmdent *
+cmd_find(const struct sysinfo *p, const char *comm)
+{
+	struct cmdent	*c;
 
-	/*
-	 * FIXME: add rproc support
-	 */
-	p->rproc_pct = .0;
+	c = p->cmds[hash_str(comm) % CMD_HASHSZ];
+	for ( ; NULL != c; c = c->next)
+		if (0 == strcmp(c->name, comm))
+			return c;
+	return NULL;
+}
 
-	return 1;
+/*
+ * Stop tracking a process, if we were.
+ */
+static void
+pid_untrack(struct sysinfo *p, pid_t pid)
+{
+	struct pident	**pp, *pe;
+
+	pp = &p->pids[(size_t)pid % PID_HASHSZ];
+	for ( ; NULL != (pe = *pp); pp = &pe->next)
+		if (pe->pid == pid) {
+			*pp = pe->next;
+			pe->cmd->nprocs--;
+			free(pe);
+			return;
+		}
 }
 
+/*
+ * Note that a process is now running the command "c", which may be
+ * NULL if it isn't a monitored command.
+ * Returns zero on memory exhaustion.
+ */
 static int
-sysinfo_update_cpu(struct sysinfo *p)
+pid_track(struct sysinfo *p, pid_t pid, struct cmdent *c)
 {
-	int64_t	val;
-	ssize_t	rd;
+	struct pident	*pe;
+	size_t		 h = (size_t)pid % PID_HASHSZ;
 
-	rd = proc_read_buf("/proc/stat");
-	if (-1 == rd)
-		return 0;
+	pid_untrack(p, pid);
+	if (NULL == c)
+		return 1;
 
-	if (10 != sscanf(buf, "cpu"
-	    " %" SCNu64
-	    " %" SCNu64
-	    " %" SCNu64
-	    " %" SCNu64
-	    " %" SCNu64
-	    " %" SCNu64
-	    " %" SCNu64
-	    " %" SCNu64
-	    " %" SCNu64
-	    " %" SCNu64,
-	    &p->cp_time[0],
-	    &p->cp_time[1],
-	    &p->cp_time[2],
-	    &p->cp_time[3],
-	    &p->cp_time[4],
-	    &p->cp_time[5],
-	    &p->cp_time[6],
-	    &p->cp_time[7],
-	    &p->cp_time[8],
-	    &p->cp_time[9])) {
-		warnx("error while parsing /proc/stat");
+	if (NULL == (pe = malloc(sizeof(struct pident)))) {
+		warn(NULL);
 		return 0;
 	}
 
-	percentages(CPUSTATES, p->cpu_states, &p->cp_time[0],
-		&p->cp_old[0], &p->cp_diff[0]);
-
-#ifdef DEBUG
-	for (int i = 0; i < CPUSTATES; i++)
-		warnx("%d: cp_time=%ld cp_old=%ld cp_diff=%ld",
-			i, p->cp_time[i], p->cp_old[i], p->cp_diff[i]);
-#endif
-
-	/* Update our averages. */
+	pe->pid = pid;
+	pe->cmd = c;
+	pe->next = p->pids[h];
+	p->pids[h] = pe;
+	c->nprocs++;
+	return 1;
+}
 
-	val = 1000 - p->cpu_states[CP_IDLE];
-	if (val > 1000) {
-		warnx("CPU state out of bound: %" PRId64, val);
-		val = 1000;
-	} else if (val < 0) {
-		warnx("CPU state out of bound: %" PRId64, val);
-		val = 0;
+/*
+ * Track a process by reading its current name from /proc/<pid>/comm.
+ * A process that has already gone away is simply not tracked.
+ * Returns zero on memory exhaustion.
+ */
+static int
+pid_classify(struct sysinfo *p, pid_t pid)
+{
+	char	 path[64], comm[COMM_MAX + 2];
+	ssize_t	 rd;
+	int	 fd;
+
+	snprintf(path, sizeof(path), "/proc/%d/comm", (int)pid);
+	if (-1 == (fd = open(path, O_RDONLY | O_CLOEXEC))) {
+		pid_untrack(p, pid);
+		return 1;
 	}
+	rd = read(fd, comm, sizeof(comm) - 1);
+	close(fd);
 
-	p->cpu_avg = val / 10.;
+	if (rd <= 0) {
+		pid_untrack(p, pid);
+		return 1;
+	}
 
-	return 1;
+	comm[rd] = '\0';
+	comm[strcspn(comm, "\n")] = '\0';
+	return pid_track(p, pid, cmd_find(p, comm));
 }
 
+/*
+ * Rebuild our process table from scratch by walking /proc.
+ * This is used when starting, if we lose connector events, and on
+ * every sample if we have no connector at all.
+ */
 static int
-get_ifflags(int *fd, const char *ifname, short *ifflags)
+rproc_scan(struct sysinfo *p)
 {
-	static struct	ifreq ifr;
+	struct dirent	*dent;
+	DIR 		*dir;
+	long long	 pid;
+	char		*ep;
 
-	if (-1 == *fd &&
-	    -1 == (*fd = socket(AF_UNIX, SOCK_DGRAM, 0))) {
+	pid_flush(p);
+
+	if (NULL == (dir = opendir("/proc"))) {
+		warn("opendir: /proc");
+		return 0;
+	}
+
+	while (NULL != (dent = readdir(dir))) {
+		if ( ! isdigit((unsigned char)*dent->d_name))
+			continue;
+		pid = strtoll(dent->d_name, &ep, 10);
+		if ('\0' != *ep || pid <= 0 || pid > INT_MAX)
+			continue;
+		if ( ! pid_classify(p, (pid_t)pid)) {
+			closedir(dir);
+			return 0;
+		}
+	}
+
+	closedir(dir);
+	return 1;
+}
+
+/*
+ * Subscribe to fork, exec, exit, and name-change events from the
+ * netlink process connector.
+ * This needs CAP_NET_ADMIN and a kernel with CONFIG_PROC_EVENTS.
+ * Returns -1 if not available, in which case we rescan /proc.
+ */
+static int
+rproc_open(void)
+{
+	struct sockaddr_nl	 sa;
+	struct {
+		struct nlmsghdr	 nh;
+		struct cn_msg	 cn;
+		enum proc_cn_mcast_op op;
+	} __attribute__((packed)) req;
+	int			 fd, sz = 1024 * 1024;
+
+	fd = socket(AF_NETLINK, SOCK_DGRAM | 
+		SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+	if (-1 == fd) {
+		warn("socket: NETLINK_CONNECTOR");
+		return -1;
+	}
+
+	/* 
+	 * We only drain between samples, so make room for bursts.
+	 * Overruns are caught as ENOBUFS and trigger a rescan.
+	 */
+
+	if (-1 == setsockopt(fd, SOL_SOCKET, 
+	    SO_RCVBUFFORCE, &sz, sizeof(sz)))
+		setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &sz, sizeof(sz));
+
+	memset(&sa, 0, sizeof(struct sockaddr_nl));
+	sa.nl_family = AF_NETLINK;
+	sa.nl_groups = CN_IDX_PROC;
+
+	if (-1 == bind(fd, (struct sockaddr *)&sa, sizeof(sa))) {
+		warn("bind: NETLINK_CONNECTOR");
+		close(fd);
+		return -1;
+	}
+
+	memset(&req, 0, sizeof(req));
+	req.nh.nlmsg_len = sizeof(req);
+	req.nh.nlmsg_type = NLMSG_DONE;
+	req.cn.id.idx = CN_IDX_PROC;
+	req.cn.id.val = CN_VAL_PROC;
+	req.cn.len = sizeof(enum proc_cn_mcast_op);
+	req.op = PROC_CN_MCAST_LISTEN;
+
+	if (-1 == send(fd, &req, sizeof(req), 0)) {
+		warn("send: NETLINK_CONNECTOR");
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/*
+ * Apply a single process event to our table.
+ * We only care about thread-group leaders, i.e., processes.
+ * Returns zero on memory exhaustion.
+ */
+static int
+rproc_event(struct sysinfo *p, const struct proc_event *ev)
+{
+	struct pident	*pe;
+
+	switch (ev->what) {
+	case PROC_EVENT_FORK:
+		if (ev->event_data.fork.child_pid != 
+		    ev->event_data.fork.child_tgid)
+			break;
+		pe = p->pids[(size_t)ev->event_data.fork.parent_tgid % 
+			PID_HASHSZ];
+		for ( ; NULL != pe; pe = pe->next)
+			if (pe->pid == ev->event_data.fork.parent_tgid)
+				break;
+		if (NULL != pe)
+			return pid_track(p, 
+				ev->event_data.fork.child_tgid, pe->cmd);
+		break;
+	case PROC_EVENT_EXEC:
+		return pid_classify(p, ev->event_data.exec.process_tgid);
+	case PROC_EVENT_COMM:
+		if (ev->event_data.comm.process_pid != 
+		    ev->event_data.comm.process_tgid)
+			break;
+		return pid_track(p, ev->event_data.comm.process_tgid,
+			cmd_find(p, ev->event_data.comm.comm));
+	case PROC_EVENT_EXIT:
+		if (ev->event_data.exit.process_pid ==
+		    ev->event_data.exit.process_tgid)
+			pid_untrack(p, ev->event_data.exit.process_tgid);
+		break;
+	default:
+		break;
+	}
+
+	return 1;
+}
+
+/*
+ * Read all pending events from the process connector.
+ * If the kernel dropped events, note that we need to rescan.
+ * Returns zero on failure.
+ */
+static int
+rproc_drain(struct sysinfo *p)
+{
+	union {
+		struct nlmsghdr	 nh;
+		char		 buf[8192];
+	} 			 u;
+	const struct nlmsghdr	*nh;
+	const struct cn_msg	*cn;
+	ssize_t			 rd;
+	size_t			 len;
+
+	for (;;) {
+		if (-1 == (rd = recv(p->cnfd, &u, sizeof(u), 0))) {
+			if (EAGAIN == errno || EWOULDBLOCK == errno)
+				return 1;
+			if (ENOBUFS == errno) {
+				p->cnresync = 1;
+				continue;
+			}
+			warn("recv: NETLINK_CONNECTOR");
+			return 0;
+		}
+		len = rd;
+		for (nh = &u.nh; NLMSG_OK(nh, len); 
+		     nh = NLMSG_NEXT(nh, len)) {
+			if (NLMSG_ERROR == nh->nlmsg_type ||
+			    NLMSG_NOOP == nh->nlmsg_type)
+				continue;
+			if (nh->nlmsg_len < NLMSG_LENGTH
+			    (sizeof(struct cn_msg) + 
+			     sizeof(struct proc_event)))
+				continue;
+			cn = NLMSG_DATA(nh);
+			if (CN_IDX_PROC != cn->id.idx ||
+			    CN_VAL_PROC != cn->id.val)
+				continue;
+			if ( ! rproc_event(p, 
+			    (const struct proc_event *)cn->data))
+				return 0;
+		}
+	}
+}
+
+/*
+ * Set up the monitored command names and seed our process table.
+ * The connector is opened before the initial scan so that no events
+ * fall between the two: replaying an event we've already seen in the
+ * scan is harmless.
+ */
+static int
+rproc_setup(const struct syscfg *cfg, struct sysinfo *p)
+{
+	struct cmdent	*c;
+	size_t		 i, h;
+
+	p->rproc_init = 1;
+
+	for (i = 0; i < cfg->cmdsz; i++) {
+		if (NULL == (c = calloc(1, sizeof(struct cmdent)))) {
+			warn(NULL);
+			return 0;
+		}
+		strlcpy(c->name, cfg->cmds[i], sizeof(c->name));
+		if (NULL != cmd_find(p, c->name)) {
+			free(c);
+			continue;
+		}
+		h = hash_str(c->name) % CMD_HASHSZ;
+		c->next = p->cmds[h];
+		p->cmds[h] = c;
+		p->cmdsz++;
+	}
+
+	if (0 == p->cmdsz)
+		return 1;
+
+	if (-1 == (p->cnfd = rproc_open()))
+		warnx("process connector unavailable: "
+			"scanning /proc each sample");
+
+	return rproc_scan(p);
+}
+
+/*
+ * Fill in the percentage of monitored commands with at least one
+ * running process.
+ * Like on OpenBSD, with no commands this is always 100%.
+ */
+static int
+sysinfo_update_rprocs(const struct syscfg *cfg, struct sysinfo *p)
+{
+	struct cmdent	*c;
+	size_t		 i, rprocs = 0;
+
+	if ( ! p->rproc_init && ! rproc_setup(cfg, p))
+		return 0;
+
+	if (0 == p->cmdsz) {
+		p->rproc_pct = 100.0;
+		return 1;
+	}
+
+	if (-1 != p->cnfd) {
+		if ( ! rproc_drain(p))
+			return 0;
+		if (p->cnresync) {
+			warnx("process connector overrun: rescanning");
+			p->cnresync = 0;
+			if ( ! rproc_scan(p))
+				return 0;
+		}
+	} else if (p->sample > 0 && ! rproc_scan(p))
+		return 0;
+
+	for (i = 0; i < CMD_HASHSZ; i++)
+		for (c = p->cmds[i]; NULL != c; c = c->next) {
+#ifdef DEBUG
+			warnx("rprocs: %s: %zu", c->name, c->nprocs);
+#endif
+			if (c->nprocs > 0)
+				rprocs++;
+		}
+
+	p->rproc_pct = 100.0 * rprocs / (double)p->cmdsz;
+	return 1;
+}
+
+/*
+ * Count tasks with the total in the fourth field of /proc/loadavg,
+ * "running/total", which the kernel keeps as a counter.
+ * The pid_max denominator is cached and re-read only occasionally.
+ */
+static int
+sysinfo_update_nprocs(const struct syscfg *cfg, struct sysinfo *p)
+{
+	uint64_t	 maxproc, nprocs, running;
+	ssize_t		 rd;
+	char		*buf, *cp, *end;
+
+	if (0 == p->maxproc || 0 == p->sample % PIDMAX_REFRESH) {
+		rd = proc_read_buf(p, PROC_PIDMAX, &buf);
+		if (-1 == rd)
+			return 0;
+		if ( ! tok_u64(&buf, buf + rd, &maxproc) || 
+		    0 == maxproc) {
+			warnx("error while parsing "
+				"/proc/sys/kernel/pid_max");
+			return 0;
+		}
+		p->maxproc = maxproc;
+	}
+
+	rd = proc_read_buf(p, PROC_LOADAVG, &buf);
+	if (-1 == rd)
+		return 0;
+
+	end = buf + rd;
+	cp = buf;
+
+	if ( ! tok_real(&cp, end, &p->load[0]) ||
+	    ! tok_real(&cp, end, &p->load[1]) ||
+	    ! tok_real(&cp, end, &p->load[2]) ||
+	    ! tok_u64(&cp, end, &running) || 
+	    cp >= end || '/' != *cp++ ||
+	    ! tok_u64(&cp, end, &nprocs)) {
+		warnx("error while parsing /proc/loadavg");
+		return 0;
+	}
+
+#ifdef DEBUG
+	warnx("procs: nprocs=%" PRIu64 " maxproc=%" PRIu64, 
+		nprocs, p->maxproc);
+#endif
+	if (cfg->validate)
+		nprocs_validate(nprocs);
+
+	p->nproc_pct = 100.0 * nprocs / (double)p->maxproc;
+	return 1;
+}
+
+/*
+ * Parse the per-core lines of /proc/stat starting at "cp" into the
+ * permille of non-idle time of each core.
+ * Cores are indexed by their number: any missing (offline) are zero.
+ * Return zero on failure, non-zero on success.
+ */
+static int
+sysinfo_update_cores(struct sysinfo *p, char *cp, const char *end)
+{
+	uint64_t	 cp_time[CPUSTATES];
+	size_t		 i, idx, max;
+	struct corestat	*cs;
+	void		*pp;
+	int		 c;
+
+	if (p->coremax > 0)
+		memset(p->corepm, 0, p->coremax * sizeof(uint16_t));
+	p->coresz = 0;
+
+	while ((c = parse_stat_core(&cp, end, &idx, cp_time)) > 0) {
+		if (idx >= p->coremax) {
+			max = idx + 1 > p->coremax * 2 ? 
+				idx + 1 : p->coremax * 2;
+			pp = recallocarray(p->cores, p->coremax, 
+				max, sizeof(struct corestat));
+			if (NULL == pp) {
+				warn(NULL);
+				return 0;
+			}
+			p->cores = pp;
+			pp = recallocarray(p->corepm, p->coremax, 
+				max, sizeof(uint16_t));
+			if (NULL == pp) {
+				warn(NULL);
+				return 0;
+			}
+			p->corepm = pp;
+			p->coremax = max;
+		}
+		cs = &p->cores[idx];
+		for (i = 0; i < CPUSTATES; i++)
+			cs->cp_time[i] = cp_time[i];
+		percentages(CPUSTATES, cs->states, 
+			cs->cp_time, cs->cp_old, cs->cp_diff);
+		p->corepm[idx] = cs->states[CP_IDLE] > 1000 ?
+			0 : 1000 - cs->states[CP_IDLE];
+		if (idx + 1 > p->coresz)
+			p->coresz = idx + 1;
+	}
+
+	if (c < 0) {
+		warnx("error while parsing /proc/stat");
+		return 0;
+	}
+	return 1;
+}
+
+static int
+sysinfo_update_cpu(struct sysinfo *p)
+{
+	int64_t	 val;
+	ssize_t	 rd;
+	char	*buf;
+	uint64_t ctxt, intr;
+
+	rd = proc_read_buf(p, PROC_STAT, &buf);
+	if (-1 == rd)
+		return 0;
+
+	if ( ! parse_stat(buf, rd, p->cp_time)) {
+		warnx("error while parsing /proc/stat");
+		return 0;
+	}
+
+	percentages(CPUSTATES, p->cpu_states, &p->cp_time[0],
+		&p->cp_old[0], &p->cp_diff[0]);
+
+#ifdef DEBUG
+	for (int i = 0; i < CPUSTATES; i++)
+		warnx("%d: cp_time=%ld cp_old=%ld cp_diff=%ld",
+			i, p->cp_time[i], p->cp_old[i], p->cp_diff[i]);
+#endif
+
+	/* Update our averages. */
+
+	val = 1000 - p->cpu_states[CP_IDLE];
+	if (val > 1000) {
+		warnx("CPU state out of bound: %" PRId64, val);
+		val = 1000;
+	} else if (val < 0) {
+		warnx("CPU state out of bound: %" PRId64, val);
+		val = 0;
+	}
+
+	p->cpu_avg = val / 10.;
+
+	if ( ! parse_stat_misc(buf, rd, 
+	    &ctxt, &intr, &p->procs_run, &p->procs_blk)) {
+		warnx("error while parsing /proc/stat");
+		return 0;
+	}
+	p->ctxt_avg = ctxt > p->ctxt ? rate(p, ctxt - p->ctxt) : 0;
+	p->intr_avg = intr > p->intr ? rate(p, intr - p->intr) : 0;
+	p->ctxt = ctxt;
+	p->intr = intr;
+
+	sysinfo_update_psi(p, PROC_PSICPU);
+	return sysinfo_update_cores(p, tok_eol(buf, buf + rd), buf + rd);
+}
+
+static int
+get_ifflags(int *fd, const char *ifname, short *ifflags)
+{
+	static struct	ifreq ifr;
+
+	if (-1 == *fd &&
+	    -1 == (*fd = socket(AF_UNIX, SOCK_DGRAM, 0))) {
 		warn("socket");
 		return 0;
 	}
@@ -458,105 +1353,370 @@ get_ifindex(struct if_nameindex *idx, const char *ifname, int *ifindex)
 	return 0;
 }
 
-#define UPDATE(x, y, up) \
+/*
+ * Append a device and its rates to "v", growing it as needed.
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+sysdev_push(struct sysdev **v, size_t *sz, size_t *max,
+	const char *name, int64_t rx, int64_t tx)
+{
+	struct sysdev	*pp;
+
+	if (*sz == *max) {
+		pp = reallocarray(*v, *max + 8, sizeof(struct sysdev));
+		if (NULL == pp) {
+			warn(NULL);
+			return 0;
+		}
+		*v = pp;
+		*max += 8;
+	}
+	strlcpy((*v)[*sz].name, name, sizeof((*v)[*sz].name));
+	(*v)[*sz].rx = rx;
+	(*v)[*sz].tx = tx;
+	(*sz)++;
+	return 1;
+}
+
+#define UPDATE(x) \
 	do { \
-		ifs->ifs_now.x = y; \
-		ifs->ifs_cur.x = ifs->ifs_now.x - ifs->ifs_old.x; \
+		ifs->ifs_cur.x = rate(p, ifs->ifs_now.x - ifs->ifs_old.x); \
 		ifs->ifs_old.x = ifs->ifs_now.x; \
-		ifs->ifs_cur.x /= 15; \
-		if ((up)) \
-			p->ifsum.x += ifs->ifs_cur.x; \
+		if (ifs->ifs_up) \
+			sum.x += ifs->ifs_cur.x; \
 	} while(0)
 
+/*
+ * Look up the per-interface statistics by index, growing the table as
+ * new interfaces appear.
+ * Returns NULL on memory exhaustion.
+ */
+static struct ifstat *
+ifstat_get(struct sysinfo *p, unsigned int ifindex)
+{
+	struct ifstat	*newstats;
+
+	if (ifindex >= p->ifstatsz) {
+		newstats = reallocarray
+			(p->ifstats, ifindex + 4,
+			 sizeof(struct ifstat));
+		if (NULL == newstats) {
+			warn(NULL);
+			return NULL;
+		}
+		p->ifstats = newstats;
+		while (p->ifstatsz < ifindex + 4) {
+			memset(&p->ifstats[p->ifstatsz], 
+				0, sizeof(*p->ifstats));
+			p->ifstatsz++;
+		}
+	}
+
+	return &p->ifstats[ifindex];
+}
+
+/*
+ * Start a dump of interface counters.
+ */
+static void
+ifstat_begin(struct sysinfo *p)
+{
+	size_t	 i;
+
+	for (i = 0; i < p->ifstatsz; i++)
+		p->ifstats[i].ifs_up = p->ifstats[i].ifs_fresh = 0;
+}
+
+/*
+ * Record an interface's counters from the dump, and whether it's up.
+ * If the index has been given to an interface of another "name" (if
+ * not NULL), the old counters are no longer its own.
+ */
+static void
+ifstat_sample(struct ifstat *ifs, const char *name, 
+	const struct ifcount *ifc, int up)
+{
+
+	if (NULL != name && strcmp(ifs->ifs_name, name)) {
+		strlcpy(ifs->ifs_name, name, sizeof(ifs->ifs_name));
+		ifs->ifs_seen = 0;
+	}
+	ifs->ifs_now = *ifc;
+	ifs->ifs_up = up;
+	ifs->ifs_fresh = 1;
+}
+
+/*
+ * Once a dump has succeeded, compute the rates of the interfaces in it
+ * and sum those that are up.
+ * Until then, nothing is touched, so a failed dump leaves the last
+ * rates in place.
+ * An interface new to its slot, or whose counters have gone backwards
+ * (as when reset), only sets the counters to rate from next time.
+ */
+static void
+ifstat_commit(struct sysinfo *p)
+{
+	struct ifstat	*ifs;
+	struct ifcount	 sum;
+	uint64_t	 oe = 0, ie = 0, co = 0;
+	size_t		 i;
+
+	memset(&sum, 0, sizeof(struct ifcount));
+
+	for (i = 0; i < p->ifstatsz; i++) {
+		ifs = &p->ifstats[i];
+		if ( ! ifs->ifs_fresh)
+			continue;
+		if ( ! ifs->ifs_seen ||
+		    ifs->ifs_now.ifc_ip < ifs->ifs_old.ifc_ip ||
+		    ifs->ifs_now.ifc_ib < ifs->ifs_old.ifc_ib ||
+		    ifs->ifs_now.ifc_ie < ifs->ifs_old.ifc_ie ||
+		    ifs->ifs_now.ifc_op < ifs->ifs_old.ifc_op ||
+		    ifs->ifs_now.ifc_ob < ifs->ifs_old.ifc_ob ||
+		    ifs->ifs_now.ifc_oe < ifs->ifs_old.ifc_oe ||
+		    ifs->ifs_now.ifc_co < ifs->ifs_old.ifc_co) {
+			memset(&ifs->ifs_cur, 0, sizeof(struct ifcount));
+			ifs->ifs_old = ifs->ifs_now;
+			ifs->ifs_seen = 1;
+			continue;
+		}
+		if (ifs->ifs_up) {
+			oe += ifs->ifs_now.ifc_oe - ifs->ifs_old.ifc_oe;
+			ie += ifs->ifs_now.ifc_ie - ifs->ifs_old.ifc_ie;
+			co += ifs->ifs_now.ifc_co - ifs->ifs_old.ifc_co;
+		}
+		UPDATE(ifc_ip);
+		UPDATE(ifc_ib);
+		UPDATE(ifc_ie);
+		UPDATE(ifc_op);
+		UPDATE(ifc_ob);
+		UPDATE(ifc_oe);
+		UPDATE(ifc_co);
+	}
+
+	p->ifsum = sum;
+	p->nettxerr = rate_real(p, oe);
+	p->netrxerr = rate_real(p, ie);
+	p->netcoll = rate_real(p, co);
+}
+
+/*
+ * Receive one datagram from the rtnetlink socket into our growable
+ * buffer, first peeking to learn its size.
+ * Returns the message length or -1 on failure.
+ */
+static ssize_t
+nl_recv(struct sysinfo *p)
+{
+	ssize_t	 rd;
+	size_t	 sz;
+	void	*pp;
+
+	rd = recv(p->nlfd, NULL, 0, MSG_PEEK | MSG_TRUNC);
+	if (-1 == rd) {
+		warn("recv: NETLINK_ROUTE");
+		return -1;
+	}
+
+	if ((size_t)rd > p->nlbufmax) {
+		sz = p->nlbufmax > 0 ? p->nlbufmax : 8192;
+		while (sz < (size_t)rd)
+			sz *= 2;
+		if (NULL == (pp = realloc(p->nlbuf, sz))) {
+			warn(NULL);
+			return -1;
+		}
+		p->nlbuf = pp;
+		p->nlbufmax = sz;
+	}
+
+	rd = recv(p->nlfd, p->nlbuf, p->nlbufmax, 0);
+	if (-1 == rd)
+		warn("recv: NETLINK_ROUTE");
+	return rd;
+}
+
+/*
+ * Handle a single RTM_NEWLINK message from the link dump.
+ * Prefer 64-bit counters, but accept the 32-bit ones from older
+ * kernels.
+ */
 static int
-sysinfo_update_if(struct sysinfo *p)
+nl_link(struct sysinfo *p, const struct nlmsghdr *nh)
+{
+	const struct ifinfomsg		*ifi;
+	const struct rtattr		*rta;
+	const struct rtnl_link_stats64	*st64 = NULL;
+	const struct rtnl_link_stats	*st32 = NULL;
+	const char			*name = NULL;
+	struct ifstat			*ifs;
+	struct ifcount			 ifc;
+	int				 len, up;
+
+	if (nh->nlmsg_len < NLMSG_LENGTH(sizeof(struct ifinfomsg))) {
+		warnx("short RTM_NEWLINK message");
+		return 0;
+	}
+
+	ifi = NLMSG_DATA(nh);
+	len = IFLA_PAYLOAD(nh);
+
+	for (rta = IFLA_RTA(ifi); RTA_OK(rta, len); 
+	     rta = RTA_NEXT(rta, len))
+		if (IFLA_STATS64 == rta->rta_type &&
+		    RTA_PAYLOAD(rta) >= sizeof(*st64))
+			st64 = RTA_DATA(rta);
+		else if (IFLA_STATS == rta->rta_type &&
+		    RTA_PAYLOAD(rta) >= sizeof(*st32))
+			st32 = RTA_DATA(rta);
+		else if (IFLA_IFNAME == rta->rta_type &&
+		    RTA_PAYLOAD(rta) > 0)
+			name = RTA_DATA(rta);
+
+	if (NULL != st64) {
+		ifc.ifc_ib = st64->rx_bytes;
+		ifc.ifc_ip = st64->rx_packets;
+		ifc.ifc_ie = st64->rx_errors;
+		ifc.ifc_ob = st64->tx_bytes;
+		ifc.ifc_op = st64->tx_packets;
+		ifc.ifc_oe = st64->tx_errors;
+		ifc.ifc_co = st64->collisions;
+	} else if (NULL != st32) {
+		ifc.ifc_ib = st32->rx_bytes;
+		ifc.ifc_ip = st32->rx_packets;
+		ifc.ifc_ie = st32->rx_errors;
+		ifc.ifc_ob = st32->tx_bytes;
+		ifc.ifc_op = st32->tx_packets;
+		ifc.ifc_oe = st32->tx_errors;
+		ifc.ifc_co = st32->collisions;
+	} else
+		return 1;
+
+	if (ifi->ifi_index <= 0)
+		return 1;
+	if (NULL == (ifs = ifstat_get(p, ifi->ifi_index)))
+		return 0;
+
+	/* Only consider non-loopback up addresses. */
+
+	up = (ifi->ifi_flags & IFF_UP) && 
+		! (ifi->ifi_flags & IFF_LOOPBACK);
+
+#ifdef DEBUG
+	warnx("netlink: ifindex=%d up=%d", ifi->ifi_index, up);
+#endif
+
+	ifstat_sample(ifs, name, &ifc, up);
+	return 1;
+}
+
+/*
+ * Get flags and counters for all links with one RTM_GETLINK dump.
+ * Returns zero on failure, in which case the caller should fall back
+ * to sysinfo_update_if_proc().
+ */
+static int
+sysinfo_update_if_nl(struct sysinfo *p)
+{
+	struct {
+		struct nlmsghdr	 nh;
+		struct ifinfomsg ifi;
+	} 			 req;
+	const struct nlmsghdr	*nh;
+	const struct nlmsgerr	*ne;
+	ssize_t			 rd;
+	size_t			 len;
+
+	memset(&req, 0, sizeof(req));
+	req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+	req.nh.nlmsg_type = RTM_GETLINK;
+	req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	req.nh.nlmsg_seq = ++p->nlseq;
+	req.ifi.ifi_family = AF_UNSPEC;
+
+	if (-1 == send(p->nlfd, &req, req.nh.nlmsg_len, 0)) {
+		warn("send: NETLINK_ROUTE");
+		return 0;
+	}
+
+	ifstat_begin(p);
+
+	for (;;) {
+		if ((rd = nl_recv(p)) <= 0)
+			return 0;
+		len = rd;
+		for (nh = (const struct nlmsghdr *)p->nlbuf; 
+		     NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
+			if (nh->nlmsg_seq != p->nlseq)
+				continue;
+			switch (nh->nlmsg_type) {
+			case NLMSG_DONE:
+				return 1;
+			case NLMSG_ERROR:
+				ne = NLMSG_DATA(nh);
+				warnx("RTM_GETLINK: %s", 
+					strerror(-ne->error));
+				return 0;
+			case RTM_NEWLINK:
+				if ( ! nl_link(p, nh))
+					return 0;
+				break;
+			default:
+				break;
+			}
+		}
+	}
+}
+
+/*
+ * Fallback interface statistics: parse /proc/net/dev and query each
+ * interface's index and flags by name.
+ */
+static int
+sysinfo_update_if_proc(struct sysinfo *p)
 {
 	struct ifcount		 ifctmp;
-	struct ifstat 		*newstats, *ifs;
+	struct ifstat 		*ifs;
 	struct if_nameindex	*idx;
-	char			*ptr, *ifname;
+	char			*buf, *ptr, *ifname;
+	const char		*end;
 	ssize_t			 rd;
-	int			 ifindex, up, sockfd = -1;
+	int			 c, ifindex, up, sockfd = -1;
 	short			 flags;
 
 	idx = if_nameindex();
 	if (NULL == idx)
 		return 0;
 
-	rd = proc_read_buf("/proc/net/dev");
+	rd = proc_read_buf(p, PROC_NETDEV, &buf);
 	if (-1 == rd)
 		goto err;
 
 	/*
 	 * Skip two header lines
 	 */
-	if (NULL == (ptr = strchr(buf, '\n')) ||
-	    NULL == (ptr = strchr(ptr+1, '\n')) ||
-	    '\0' == *++ptr)
-		goto errparse;
 
+	end = buf + rd;
+	ptr = tok_eol(tok_eol(buf, end), end);
 
-	memset(&p->ifsum, 0, sizeof(p->ifsum));
+	ifstat_begin(p);
 
-	for (; ptr < buf+rd; ptr++) {
-		/*
-		 * Get interface name, skip leading spaces
-		 */
-		for (;*ptr == ' '; ptr++) ;
-		ifname = ptr;
-		if (NULL == (ptr = strchr(ptr, ':')))
+	while (0 != (c = parse_netdev(&ptr, end, &ifname, &ifctmp))) {
+		if (c < 0)
 			goto errparse;
-		*ptr++ = '\0';
 
 		if ( ! get_ifindex(idx, ifname, &ifindex)) {
 			warnx("couldn't find ifindex for '%s'", ifname);
 			goto err;
 		}
 
-		sscanf(ptr,
-		    " %" SCNu64  // rx-bytes
-		    " %" SCNu64  // rx-packets
-		    " %" SCNu64  // rx-errors
-		    " %*u"       // rx-drop
-		    " %*u"       // rx-fifo
-		    " %*u"       // rx-frame
-		    " %*u"       // rx-compressed
-		    " %*u"       // rx-multicast
-		    " %" SCNu64  // tx-bytes
-		    " %" SCNu64  // tx-packates
-		    " %" SCNu64  // tx-errors
-		    " %*u"       // tx-drop
-		    " %*u"       // tx-fifo
-		    " %" SCNu64  // tx-collisions
-		    " %*u"       // tx-carrier
-		    " %*u" ,     // tx-compressed
-		    &ifctmp.ifc_ib,
-		    &ifctmp.ifc_ip,
-		    &ifctmp.ifc_ie,
-		    &ifctmp.ifc_ob,
-		    &ifctmp.ifc_op,
-		    &ifctmp.ifc_oe,
-		    &ifctmp.ifc_co);
-
 		if ( ! get_ifflags(&sockfd, ifname, &flags))
 			goto err;
 
-		if ((unsigned int)ifindex >= p->ifstatsz) {
-			newstats = reallocarray
-				(p->ifstats, ifindex + 4,
-				 sizeof(struct ifstat));
-			if (NULL == newstats) {
-				warn(NULL);
-				goto err;
-			}
-			p->ifstats = newstats;
-			while (p->ifstatsz < (unsigned int)ifindex + 4) {
-				memset(&p->ifstats[p->ifstatsz], 
-					0, sizeof(*p->ifstats));
-				p->ifstatsz++;
-			}
-		}
-		ifs = &p->ifstats[ifindex];
+		if (NULL == (ifs = ifstat_get(p, ifindex)))
+			goto err;
 
 		/* Only consider non-loopback up addresses. */
 
@@ -566,16 +1726,7 @@ sysinfo_update_if(struct sysinfo *p)
 		warnx("%s: ifindex=%d up=%d", ifname, ifindex, up);
 #endif
 
-		UPDATE(ifc_ip, ifctmp.ifc_ip, up);
-		UPDATE(ifc_ib, ifctmp.ifc_ib, up);
-		UPDATE(ifc_ie, ifctmp.ifc_ie, up);
-		UPDATE(ifc_op, ifctmp.ifc_op, up);
-		UPDATE(ifc_ob, ifctmp.ifc_ob, up);
-		UPDATE(ifc_oe, ifctmp.ifc_oe, up);
-		UPDATE(ifc_co, ifctmp.ifc_co, up);
-
-		if (NULL == (ptr = strchr(ptr, '\n')))
-			goto errparse;
+		ifstat_sample(ifs, ifname, &ifctmp, up);
 	}
 
 	close(sockfd);
@@ -589,16 +1740,65 @@ err:
 	return 0;
 }
 
+/*
+ * Use rtnetlink if we have it, permanently switching to the /proc
+ * fallback if it fails.
+ * Both report the same kernel counters, so switching over mid-stream
+ * doesn't perturb the running differences.
+ */
+static int
+sysinfo_update_if_rates(struct sysinfo *p)
+{
+
+	if (-1 != p->nlfd) {
+		if (sysinfo_update_if_nl(p))
+			return 1;
+		warnx("rtnetlink failed: using /proc/net/dev");
+		close(p->nlfd);
+		p->nlfd = -1;
+	}
+
+	return sysinfo_update_if_proc(p);
+}
+
+/*
+ * Update interface rates, then list those interfaces counted in the
+ * sums.
+ */
+static int
+sysinfo_update_if(struct sysinfo *p)
+{
+	const struct ifstat *ifs;
+	size_t		 i;
+
+	if ( ! sysinfo_update_if_rates(p))
+		return 0;
+	ifstat_commit(p);
+
+	p->ifdevsz = 0;
+	for (i = 0; i < p->ifstatsz; i++) {
+		ifs = &p->ifstats[i];
+		if (ifs->ifs_up && ! sysdev_push(&p->ifdevs, 
+		    &p->ifdevsz, &p->ifdevmax, ifs->ifs_name,
+		    ifs->ifs_cur.ifc_ib, ifs->ifs_cur.ifc_ob))
+			return 0;
+	}
+	return 1;
+}
+
 static int
-is_real_block_device(char *name)
+is_real_block_device(const char *name)
 {
-	char	 path[PATH_MAX];
+	char	 path[PATH_MAX], dev[NAME_MAX + 1];
 	char	*p;
 
+	if (strlcpy(dev, name, sizeof(dev)) >= sizeof(dev))
+		return 0;
+
 	/*
 	 * iostat replaces slashes in device names with `!`
 	 */
-	p = name;
+	p = dev;
 	while (NULL != (p = strchr(p, '/')))
 		*p = '!';
 
@@ -606,63 +1806,281 @@ is_real_block_device(char *name)
 	 * real devices have the `device` symlink in their
 	 * `/sys/block/<disk>` directory.
 	 */
-	snprintf(path, sizeof path, "/sys/block/%s/device", name);
+	snprintf(path, sizeof path, "/sys/block/%s/device", dev);
 	return 0 == access(path, F_OK);
 }
 
+/*
+ * Decide whether to sum the named device.
+ * If we have a list of discs, use only those; otherwise, use all real
+ * block devices.
+ */
+static int
+disc_classify(const struct syscfg *cfg, const char *name)
+{
+	size_t	 i;
+
+	if (0 == cfg->discsz)
+		return is_real_block_device(name);
+
+	for (i = 0; i < cfg->discsz; i++)
+		if (0 == strcmp(cfg->discs[i], name))
+			return 1;
+	return 0;
+}
+
+/*
+ * Look up whether to use a disc, classifying and caching it if we
+ * haven't seen it before.
+ * The cached entry is set in "dp".
+ * Returns <0 on memory exhaustion, 0 to skip, >0 to use.
+ */
+static int
+disc_use(const struct syscfg *cfg, struct sysinfo *p, 
+	const char *name, struct discent **dp)
+{
+	struct discent	*d;
+	size_t		 h = hash_str(name) % DISC_HASHSZ;
+
+	for (d = p->discs[h]; NULL != d; d = d->next)
+		if (0 == strcmp(d->name, name)) {
+			*dp = d;
+			return d->use;
+		}
+
+	if (NULL == (d = calloc(1, sizeof(struct discent))) ||
+	    NULL == (d->name = strdup(name))) {
+		warn(NULL);
+		free(d);
+		return -1;
+	}
+
+	d->use = disc_classify(cfg, name);
+	d->next = p->discs[h];
+	p->discs[h] = d;
+	*dp = d;
+
+#ifdef DEBUG
+	warnx("disc: %s: use=%d", name, d->use);
+#endif
+
+	return d->use;
+}
+
+/*
+ * Drop the cached classification of the named disc, if any.
+ */
+static void
+disc_drop(struct sysinfo *p, const char *name)
+{
+	struct discent	*d, **dp;
+
+	dp = &p->discs[hash_str(name) % DISC_HASHSZ];
+	for ( ; NULL != (d = *dp); dp = &d->next)
+		if (0 == strcmp(d->name, name)) {
+			*dp = d->next;
+			free(d->name);
+			free(d);
+			return;
+		}
+}
+
+/*
+ * Drop the cached classifications of discs not listed in the last
+ * scan of /proc/diskstats, i.e., that have gone away.
+ */
+static void
+disc_prune(struct sysinfo *p)
+{
+	struct discent	*d, **dp;
+	size_t		 i;
+
+	for (i = 0; i < DISC_HASHSZ; i++)
+		for (dp = &p->discs[i]; NULL != (d = *dp); )
+			if (d->scan != p->discscan) {
+				*dp = d->next;
+				free(d->name);
+				free(d);
+			} else
+				dp = &d->next;
+}
+
+/*
+ * Handle the uevent "buf" of size "sz", a header followed by
+ * NUL-separated KEY=value pairs: if a block device has been added,
+ * removed, or renamed, drop its classification so that it's
+ * re-classified when next seen.
+ */
+static void
+disc_uevent(struct sysinfo *p, const char *buf, size_t sz)
+{
+	const char	*cp, *end = buf + sz, *name = NULL;
+	int		 block = 0, action = 0;
+
+	for (cp = buf; cp < end; cp += strlen(cp) + 1)
+		if (0 == strcmp(cp, "SUBSYSTEM=block"))
+			block = 1;
+		else if (0 == strcmp(cp, "ACTION=add") ||
+		         0 == strcmp(cp, "ACTION=remove") ||
+		         0 == strcmp(cp, "ACTION=move"))
+			action = 1;
+		else if (0 == strncmp(cp, "DEVNAME=", 8))
+			name = cp + 8;
+
+	if ( ! block || ! action || NULL == name)
+		return;
+
+#ifdef DEBUG
+	warnx("disc: %s: uevent", name);
+#endif
+	disc_drop(p, name);
+}
+
+/*
+ * Process the kernel's uevents of devices coming and going or, if we
+ * can't listen for them, re-classify all discs every DISC_REFRESH
+ * scans.
+ * If the kernel had to drop events, start over.
+ * Returns zero on failure.
+ */
+static int
+disc_check(const struct syscfg *cfg, struct sysinfo *p)
+{
+	struct sockaddr_nl	 sa;
+	socklen_t		 salen;
+	struct discent		*d;
+	char			 buf[8192];
+	ssize_t			 rd;
+	size_t			 i;
+
+	if (-1 == p->discfd) {
+		if (0 != p->discscan % DISC_REFRESH)
+			return 1;
+		for (i = 0; i < DISC_HASHSZ; i++)
+			for (d = p->discs[i]; NULL != d; d = d->next)
+				d->use = disc_classify(cfg, d->name);
+		return 1;
+	}
+
+	for (;;) {
+		salen = sizeof(sa);
+		rd = recvfrom(p->discfd, buf, sizeof(buf) - 1, 0,
+			(struct sockaddr *)&sa, &salen);
+		if (-1 == rd)
+			break;
+		if (0 != sa.nl_pid)
+			continue; /* only trust the kernel */
+		buf[rd] = '\0';
+		disc_uevent(p, buf, rd);
+	}
+
+	if (EAGAIN == errno)
+		return 1;
+	if (ENOBUFS == errno) {
+		disc_flush(p);
+		return 1;
+	}
+	warn("recvfrom: NETLINK_KOBJECT_UEVENT");
+	return 0;
+}
+
+/*
+ * Per-second rate of a disc counter, zero if we've no previous value
+ * (it's new or the classifications were flushed) or it went backward.
+ */
+static int64_t
+disc_rate(const struct sysinfo *p, 
+	const struct discent *d, uint64_t old, uint64_t new)
+{
+
+	return d->seen && new > old ? rate(p, new - old) : 0;
+}
+
 static int
 sysinfo_update_disc(const struct syscfg *cfg, struct sysinfo *p)
 {
 	ssize_t		 rd;
-	char		 name[128];
-	unsigned long	 secrd, secwr;
-	char		*ptr;
-	uint64_t	 rs = 0, ws = 0;
-	uint64_t	 rb = 0, wb = 0;
+	char		*buf, *ptr, *name;
+	int		 c;
+	struct discent	*d;
+	struct discio	 io;
+	uint64_t	 rb, wb, rsum = 0, wsum = 0;
+	uint64_t	 ios = 0, ticks = 0;
+	double		 busy, maxbusy = 0.0;
+
+	p->discscan++;
+	if ( ! disc_check(cfg, p))
+		return 0;
 
-	rd = proc_read_buf("/proc/diskstats");
+	rd = proc_read_buf(p, PROC_DISKSTATS, &buf);
 	if (-1 == rd)
 		return 0;
 
-	for (ptr = buf; ptr < buf+rd; ptr++) {
-		/*
-		 * field 3  = device name
-		 * field 6  = sectors read
-		 * field 10 = sectors written
-		 */
-		if (3 != sscanf(ptr, "%*u %*u %127s "
-		    "%*u %*u %lu %*u %*u %*u %lu %*u %*u %*u %*u",
-		    name, &secrd, &secwr))
+	ptr = buf;
+	p->discdevsz = 0;
+	while (0 != (c = parse_diskstats
+	       (&ptr, buf + rd, &name, &io))) {
+		if (c < 0)
 			goto errparse;
-		if (NULL == (ptr = strchr(ptr, '\n')))
-			goto errparse;
-		if ( ! is_real_block_device(name))
+		if ((c = disc_use(cfg, p, name, &d)) < 0)
+			return 0;
+		d->scan = p->discscan;
+		if (0 == c)
 			continue;
-		rs += secrd;
-		ws += secwr;
-	}
+		rb = io.secrd << SECTOR_SHIFT;
+		wb = io.secwr << SECTOR_SHIFT;
 
-	rb = rs << SECTOR_SHIFT;
-	wb = ws << SECTOR_SHIFT;
+		/*
+		 * Totals are summed from each disc's own difference, so
+		 * that a disc appearing or going away doesn't count its
+		 * lifetime bytes or make the total go backwards.
+		 * Latency is the time spent in the I/Os completed since
+		 * the last sample over their number; utilisation is of
+		 * the busiest disc, as summing it over discs is
+		 * meaningless.
+		 */
 
-	if (rb > p->disc_rbytes) {
-		p->disc_ravg = (rb - p->disc_rbytes) / 15;
-		p->disc_rbytes = rb;
-	} else {
-		p->disc_ravg = 0;
-		p->disc_rbytes = rb;
+		if (d->seen && io.ios > d->ios) {
+			ios += io.ios - d->ios;
+			if (io.ticks > d->ticks)
+				ticks += io.ticks - d->ticks;
+		}
+		if (d->seen && io.busy > d->busy && p->elapsed > 0.0) {
+			busy = (io.busy - d->busy) / (10.0 * p->elapsed);
+			if (busy > maxbusy)
+				maxbusy = busy;
+		}
+		d->ios = io.ios;
+		d->ticks = io.ticks;
+		d->busy = io.busy;
+
+		if (d->seen && rb > d->rbytes)
+			rsum += rb - d->rbytes;
+		if (d->seen && wb > d->wbytes)
+			wsum += wb - d->wbytes;
+
+		if ( ! sysdev_push(&p->discdevs, &p->discdevsz, 
+		    &p->discdevmax, name, 
+		    disc_rate(p, d, d->rbytes, rb),
+		    disc_rate(p, d, d->wbytes, wb)))
+			return 0;
+		d->rbytes = rb;
+		d->wbytes = wb;
+		d->seen = 1;
 	}
 
-	if (wb > p->disc_wbytes) {
-		p->disc_wavg = (wb - p->disc_wbytes) / 15;
-		p->disc_wbytes = wb;
-	} else {
-		p->disc_wavg = 0;
-		p->disc_wbytes = wb;
-	}
+	disc_prune(p);
+	sysinfo_update_psi(p, PROC_PSIIO);
+
+	p->disc_iops = rate(p, ios);
+	p->disc_await = ios > 0 ? (double)ticks / ios : 0.0;
+	p->disc_busy = maxbusy > 100.0 ? 100.0 : maxbusy;
+
+	p->disc_ravg = rate(p, rsum);
+	p->disc_wavg = rate(p, wsum);
 
 #ifdef DEBUG
-	warnx("disc: rbytes=%lu wbytes=%lu", p->disc_rbytes, p->disc_rbytes);
+	warnx("disc: rbytes=%" PRIu64 " wbytes=%" PRIu64, rsum, wsum);
 #endif
 
 	return 1;
@@ -671,23 +2089,76 @@ errparse:
 	return 0;
 }
 
+/*
+ * Sample each source that's due in this update, as given by its divisor
+ * in "cfg".
+ * If "cfg" is a burst (a sample between regular updates), only sources
+ * sampled at every update are due and the update isn't counted.
+ * Sources not due keep their last values.
+ * A source that fails is marked as stale (keeping its last values, too)
+ * and retried at its next turn.
+ * Rates are over the time since the source was last sampled.
+ * Return zero on failure, non-zero on success.
+ */
 int
 sysinfo_update(const struct syscfg *cfg, struct sysinfo *p)
 {
-	if ( ! sysinfo_update_nprocs(cfg, p))
-		return 0;
-	if ( ! sysinfo_update_nfiles(cfg, p))
-		return 0;
-	if ( ! sysinfo_update_cpu(p))
-		return 0;
-	if ( ! sysinfo_update_mem(p))
-		return 0;
-	if ( ! sysinfo_update_if(p))
-		return 0;
-	if ( ! sysinfo_update_disc(cfg, p))
+	struct timespec	 now, start, end;
+	size_t		 i;
+	int		 rc;
+
+	if (-1 == clock_gettime(CLOCK_MONOTONIC, &now)) {
+		warn("clock_gettime");
 		return 0;
+	}
+
+	for (i = 0; i < SYSRC__MAX; i++) {
+		p->took[i] = -1.0;
+		if (cfg->divs[i] > 1 && 
+		    (cfg->burst || 0 != p->sample % cfg->divs[i]))
+			continue;
+		p->elapsed = 0 == p->last[i].tv_sec ? 0.0 :
+			(now.tv_sec - p->last[i].tv_sec) +
+			(now.tv_nsec - p->last[i].tv_nsec) /
+			1000000000.0;
+		if (-1 == clock_gettime(CLOCK_MONOTONIC, &start))
+			start = now;
+		switch (i) {
+		case SYSRC_CPU:
+			rc = sysinfo_update_cpu(p);
+			break;
+		case SYSRC_MEM:
+			rc = sysinfo_update_mem(p);
+			break;
+		case SYSRC_NET:
+			rc = sysinfo_update_if(p);
+			break;
+		case SYSRC_DISC:
+			rc = sysinfo_update_disc(cfg, p);
+			break;
+		case SYSRC_PROCS:
+			rc = sysinfo_update_nprocs(cfg, p);
+			break;
+		case SYSRC_RPROCS:
+			rc = sysinfo_update_rprocs(cfg, p);
+			break;
+		case SYSRC_FILES:
+			rc = sysinfo_update_nfiles(cfg, p);
+			break;
+		default:
+			abort();
+		}
+		if (0 == clock_gettime(CLOCK_MONOTONIC, &end))
+			p->took[i] = (end.tv_sec - start.tv_sec) +
+				(end.tv_nsec - start.tv_nsec) / 
+				1000000000.0;
+		if ((p->stale[i] = ! rc))
+			continue;
+		p->last[i] = now;
+	}
 
-	p->sample++;
+	if ( ! cfg->burst)
+		p->sample++;
 	return 1;
 }
 
@@ -723,6 +2194,51 @@ sysinfo_get_netrx_avg(const struct sysinfo *p)
 	return p->ifsum.ifc_ib;
 }
 
+int64_t
+sysinfo_get_nettxpkt_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0;
+	return p->ifsum.ifc_op;
+}
+
+int64_t
+sysinfo_get_netrxpkt_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0;
+	return p->ifsum.ifc_ip;
+}
+
+double
+sysinfo_get_nettxerr_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0.0;
+	return p->nettxerr;
+}
+
+double
+sysinfo_get_netrxerr_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0.0;
+	return p->netrxerr;
+}
+
+double
+sysinfo_get_netcoll_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0.0;
+	return p->netcoll;
+}
+
 int64_t
 sysinfo_get_discread_avg(const struct sysinfo *p)
 {
@@ -741,6 +2257,100 @@ sysinfo_get_discwrite_avg(const struct sysinfo *p)
 	return p->disc_wavg;
 }
 
+int64_t
+sysinfo_get_disciops_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0;
+	return p->disc_iops;
+}
+
+double
+sysinfo_get_discawait_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0.0;
+	return p->disc_await;
+}
+
+double
+sysinfo_get_discbusy_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0.0;
+	return p->disc_busy;
+}
+
+int64_t
+sysinfo_get_ctxt_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0;
+	return p->ctxt_avg;
+}
+
+int64_t
+sysinfo_get_intr_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0;
+	return p->intr_avg;
+}
+
+double
+sysinfo_get_procsrun(const struct sysinfo *p)
+{
+
+	return p->procs_run;
+}
+
+double
+sysinfo_get_procsblk(const struct sysinfo *p)
+{
+
+	return p->procs_blk;
+}
+
+double
+sysinfo_get_load1(const struct sysinfo *p)
+{
+
+	return p->load[0];
+}
+
+double
+sysinfo_get_load5(const struct sysinfo *p)
+{
+
+	return p->load[1];
+}
+
+double
+sysinfo_get_load15(const struct sysinfo *p)
+{
+
+	return p->load[2];
+}
+
+double
+sysinfo_get_psi_some(const struct sysinfo *p, enum psirc r)
+{
+
+	return p->psi_some[r];
+}
+
+double
+sysinfo_get_psi_full(const struct sysinfo *p, enum psirc r)
+{
+
+	return p->psi_full[r];
+}
+
 double
 sysinfo_get_rprocs(const struct sysinfo *p)
 {
@@ -768,4 +2378,50 @@ sysinfo_get_boottime(const struct sysinfo *p)
 
 	return p->boottime;
 }
+
+size_t
+sysinfo_get_cores(const struct sysinfo *p, const uint16_t **v)
+{
+
+	*v = p->corepm;
+	return p->coresz;
+}
+
+size_t
+sysinfo_get_ifs(const struct sysinfo *p, const struct sysdev **v)
+{
+
+	*v = p->ifdevs;
+	return p->ifdevsz;
+}
+
+size_t
+sysinfo_get_discs(const struct sysinfo *p, const struct sysdev **v)
+{
+
+	*v = p->discdevs;
+	return p->discdevsz;
+}
+
+size_t
+sysinfo_get_metrics(const struct sysinfo *p, const struct sysmetric **v)
+{
+
+	*v = p->metrics;
+	return SYSMET__MAX;
+}
+
+int
+sysinfo_get_stale(const struct sysinfo *p, enum sysrc src)
+{
+
+	return p->stale[src];
+}
+
+double
+sysinfo_get_took(const struct sysinfo *p, enum sysrc src)
+{
+
+	return p->took[src];
+}
 #endif
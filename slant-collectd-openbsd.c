@@ -57,7 +57,9 @@
 #include <sys/sched.h>
 #include <sys/socket.h>
 #include <sys/sysctl.h>
+#include <sys/vmmeter.h>
 #include <net/if.h>
+#include <net/if_dl.h>
 #include <net/route.h>
 #include <sys/ioctl.h>
 #include <sys/disk.h>
@@ -70,6 +72,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "slant-collectd.h"
@@ -91,6 +94,31 @@ struct	ifstat {
 	struct ifcount	ifs_old;
 	struct ifcount	ifs_now;
 	char		ifs_flag;
+	char		ifs_name[IFNAMSIZ]; /* last known name */
+};
+
+/*
+ * Last counters of a disc, by its position in HW_DISKSTATS.
+ */
+struct	discstat {
+	char		ds_name[DS_DISKNAMELEN]; /* name or empty */
+	u_int64_t	ds_rbytes; /* last read bytes */
+	u_int64_t	ds_wbytes; /* last written bytes */
+	u_int64_t	ds_xfer; /* last transfers */
+	struct timeval	ds_time; /* last time busy */
+};
+
+/*
+ * Metrics without record fields of their own.
+ * See sysinfo_get_metrics().
+ */
+enum	sysmet {
+	SYSMET_SWAP = 0,
+	SYSMET__MAX
+};
+
+static const char *const sysmets[SYSMET__MAX] = {
+	"swap", /* SYSMET_SWAP */
 };
 
 /* 
@@ -110,15 +138,42 @@ struct	sysinfo {
 	int64_t        **cp_old; /* used for cpu compute */
 	int64_t        **cp_diff; /* used for cpu compute */
 	size_t		 ncpu; /* number cpus */
+	uint16_t	*corepm; /* per-cpu permille busy */
 	double		 rproc_pct; /* pct command (by name) found */
 	struct ifstat	*ifstats; /* used for inet compute */
 	size_t		 ifstatsz; /* used for inet compute */
 	struct ifcount	 ifsum; /* average inet */
+	double		 nettxerr; /* output errors/second */
+	double		 netrxerr; /* input errors/second */
+	double		 netcoll; /* collisions/second */
+	struct sysdev	*ifdevs; /* per-interface rates */
+	size_t		 ifdevsz; /* interfaces in last sample */
+	size_t		 ifdevmax; /* allocated size of ifdevs */
+	struct discstat	*discstats; /* per-disc counters */
+	size_t		 discstatsz; /* size of discstats */
+	struct sysdev	*discdevs; /* per-disc rates */
+	size_t		 discdevsz; /* discs in last sample */
+	size_t		 discdevmax; /* allocated size of discdevs */
 	u_int64_t	 disc_rbytes; /* last disc total read */
 	u_int64_t	 disc_wbytes; /* last disc total write */
 	int64_t	 	 disc_ravg; /* average reads/sec */
 	int64_t	 	 disc_wavg; /* average reads/sec */
+	int64_t		 disc_iops; /* transfers/sec */
+	double		 disc_await; /* average busy ms per transfer */
+	double		 disc_busy; /* busiest disc, percent */
 	time_t		 boottime; /* time booted */
+	u_int64_t	 swtch; /* last context switches */
+	u_int64_t	 intrs; /* last interrupts */
+	int64_t		 ctxt_avg; /* context switches/sec */
+	int64_t		 intr_avg; /* interrupts/sec */
+	double		 procs_run; /* runnable threads */
+	double		 procs_blk; /* threads in disc or page wait */
+	double		 load[3]; /* 1, 5, 15 minute load */
+	struct sysmetric metrics[SYSMET__MAX]; /* see sysinfo_get_metrics */
+	struct timespec	 last[SYSRC__MAX]; /* time of last sample */
+	int		 stale[SYSRC__MAX]; /* last sample failed */
+	double		 took[SYSRC__MAX]; /* seconds to sample or -1 */
+	double		 elapsed; /* seconds since source last sampled */
 };
 
 /*
@@ -220,7 +275,11 @@ sysinfo_free(struct sysinfo *p)
 	free(p->cp_old);
 	free(p->cp_diff);
 	free(p->cpu_states);
+	free(p->corepm);
 	free(p->ifstats);
+	free(p->ifdevs);
+	free(p->discstats);
+	free(p->discdevs);
 	free(p);
 }
 
@@ -262,16 +321,21 @@ sysinfo_alloc(void)
 
 	assert(p->ncpu > 0);
 
+	for (i = 0; i < SYSMET__MAX; i++)
+		p->metrics[i].name = sysmets[i];
+
 	p->cpu_states = calloc
 		(p->ncpu, CPUSTATES * sizeof(int64_t));
 	p->cp_time = calloc(p->ncpu, sizeof(int64_t *));
 	p->cp_old = calloc(p->ncpu, sizeof(int64_t *));
 	p->cp_diff = calloc(p->ncpu, sizeof(int64_t *));
+	p->corepm = calloc(p->ncpu, sizeof(uint16_t));
 
 	if (NULL == p->cpu_states ||
 	    NULL == p->cp_time ||
 	    NULL == p->cp_old ||
-	    NULL == p->cp_diff) {
+	    NULL == p->cp_diff ||
+	    NULL == p->corepm) {
 		warn(NULL);
 		sysinfo_free(p);
 		return NULL;
@@ -330,6 +394,8 @@ sysinfo_update_mem(struct sysinfo *p)
 	p->mem_avg = 100.0 *
 		PAGETOK(uvmexp.active, p->pageshift) /
 		(double)PAGETOK(uvmexp.npages, p->pageshift);
+	p->metrics[SYSMET_SWAP].value = uvmexp.swpages > 0 ?
+		100.0 * uvmexp.swpginuse / uvmexp.swpages : 0.0;
 	return 1;
 }
 
@@ -363,13 +429,10 @@ sysinfo_update_nfiles(const struct syscfg *cfg, struct sysinfo *p)
 static int
 sysinfo_update_nprocs(const struct syscfg *cfg, struct sysinfo *p)
 {
-	size_t	 i, j, size, len, rprocs = 0;
+	size_t	 size;
 	int	 maxproc, nprocs;
 	int	 cp_nproc_mib[] = { CTL_KERN, KERN_NPROCS },
-		 cp_maxproc_mib[] = { CTL_KERN, KERN_MAXPROC },
-		 cp_procs_mib[] = { CTL_KERN, KERN_PROC, 
-			 0, 0, sizeof(struct kinfo_proc), 0};
-	struct kinfo_proc *pb = NULL;
+		 cp_maxproc_mib[] = { CTL_KERN, KERN_MAXPROC };
 
 	size = sizeof(int);
 	if (sysctl(cp_maxproc_mib, 2, &maxproc, &size, NULL, 0) < 0) {
@@ -380,21 +443,34 @@ sysinfo_update_nprocs(const struct syscfg *cfg, struct sysinfo *p)
 		return 0;
 	}
 
-	/*
-	 * If we're only going to look at the number of processes, then
-	 * there's no need for us to look at the kinfo_proc: we always
-	 * have 100% running (of... none).
-	 * So short-circuit here.
-	 */
+	size = sizeof(int);
+	if (sysctl(cp_nproc_mib, 2, &nprocs, &size, NULL, 0) < 0) {
+		warn("sysctl: CTL_KERN, KERN_NPROCS");
+		return 0;
+	}
+	if (-1 == getloadavg(p->load, 3)) {
+		warnx("getloadavg");
+		return 0;
+	}
+	p->nproc_pct = 100.0 * nprocs / (double)maxproc;
+	return 1;
+}
+
+/*
+ * Fill in the percentage of monitored commands with at least one
+ * running process.
+ * If we're not monitoring any, there's no need for us to look at the
+ * kinfo_proc: we always have 100% running (of... none).
+ */
+static int
+sysinfo_update_rprocs(const struct syscfg *cfg, struct sysinfo *p)
+{
+	size_t	 i, j, size, len, rprocs = 0;
+	int	 cp_procs_mib[] = { CTL_KERN, KERN_PROC, 
+			 0, 0, sizeof(struct kinfo_proc), 0};
+	struct kinfo_proc *pb = NULL;
 
 	if (0 == cfg->cmdsz) {
-		size = sizeof(int);
-		if (sysctl(cp_nproc_mib, 2, 
-		    &nprocs, &size, NULL, 0) < 0) {
-			warn("sysctl: CTL_KERN, KERN_NPROCS");
-			return 0;
-		}
-		p->nproc_pct = 100.0 * nprocs / (double)maxproc;
 		p->rproc_pct = 100.0;
 		return 1;
 	}
@@ -434,7 +510,6 @@ retry:
 	}
 
 	free(pb);
-	p->nproc_pct = 100.0 * len / (double)maxproc;
 	p->rproc_pct = 100.0 * rprocs / (double)cfg->cmdsz;
 	return 1;
 }
@@ -504,6 +579,7 @@ sysinfo_update_cpu(struct sysinfo *p)
 			warnx("CPU state out of bound: %" PRId64, val);
 			val = 0;
 		}
+		p->corepm[i] = val;
 		sum += val / 10.;
 	}
 
@@ -511,21 +587,115 @@ sysinfo_update_cpu(struct sysinfo *p)
 	return 1;
 }
 
+/*
+ * Convert a counter difference into a per-second rate over the time
+ * since the current source was last sampled.
+ */
+static uint64_t
+rate(const struct sysinfo *p, uint64_t delta)
+{
+
+	return p->elapsed > 0.0 ? delta / p->elapsed : 0;
+}
+
+/*
+ * Like rate(), but keeping the fraction for rare events like errors.
+ */
+static double
+rate_real(const struct sysinfo *p, uint64_t delta)
+{
+
+	return p->elapsed > 0.0 ? delta / p->elapsed : 0.0;
+}
+
+/*
+ * Context switches and interrupts per second and the run queue.
+ * Return zero on failure, non-zero on success.
+ */
+static int
+sysinfo_update_sched(struct sysinfo *p)
+{
+	int		 uvmexp_mib[] = { CTL_VM, VM_UVMEXP },
+			 meter_mib[] = { CTL_VM, VM_METER };
+	struct uvmexp	 uvmexp;
+	struct vmtotal	 vmt;
+	size_t		 size;
+
+	size = sizeof(uvmexp);
+	if (sysctl(uvmexp_mib, 2, &uvmexp, &size, NULL, 0) < 0) {
+		warn("sysctl: CTL_VM, VM_UVMEXP");
+		return 0;
+	}
+	size = sizeof(vmt);
+	if (sysctl(meter_mib, 2, &vmt, &size, NULL, 0) < 0) {
+		warn("sysctl: CTL_VM, VM_METER");
+		return 0;
+	}
+
+	p->ctxt_avg = (u_int64_t)uvmexp.swtch > p->swtch ?
+		rate(p, uvmexp.swtch - p->swtch) : 0;
+	p->intr_avg = (u_int64_t)uvmexp.intrs > p->intrs ?
+		rate(p, uvmexp.intrs - p->intrs) : 0;
+	p->swtch = uvmexp.swtch;
+	p->intrs = uvmexp.intrs;
+	p->procs_run = vmt.t_rq;
+	p->procs_blk = vmt.t_dw + vmt.t_pw;
+	return 1;
+}
+
+/*
+ * Append a device and its rates to "v", growing it as needed.
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+sysdev_push(struct sysdev **v, size_t *sz, size_t *max,
+	const char *name, int64_t rx, int64_t tx)
+{
+	struct sysdev	*pp;
+
+	if (*sz == *max) {
+		pp = reallocarray(*v, *max + 8, sizeof(struct sysdev));
+		if (NULL == pp) {
+			warn(NULL);
+			return 0;
+		}
+		*v = pp;
+		*max += 8;
+	}
+	strlcpy((*v)[*sz].name, name, sizeof((*v)[*sz].name));
+	(*v)[*sz].rx = rx;
+	(*v)[*sz].tx = tx;
+	(*sz)++;
+	return 1;
+}
+
 #define UPDATE(x, y, up) \
 	do { \
 		ifs->ifs_now.x = ifm.y; \
-		ifs->ifs_cur.x = ifs->ifs_now.x - ifs->ifs_old.x; \
+		ifs->ifs_cur.x = rate(p, ifs->ifs_now.x - ifs->ifs_old.x); \
 		ifs->ifs_old.x = ifs->ifs_now.x; \
-		ifs->ifs_cur.x /= 15; \
 		if ((up)) \
 			p->ifsum.x += ifs->ifs_cur.x; \
 	} while(0)
 
+/*
+ * Like UPDATE(), but summing the fractional rate into "v".
+ */
+#define UPDATE_REAL(x, y, up, v) \
+	do { \
+		ifs->ifs_now.x = ifm.y; \
+		if ((up)) \
+			(v) += rate_real(p, \
+				ifs->ifs_now.x - ifs->ifs_old.x); \
+		ifs->ifs_old.x = ifs->ifs_now.x; \
+	} while(0)
+
 static int
 sysinfo_update_if(struct sysinfo *p)
 {
 	struct ifstat 	*newstats, *ifs;
 	struct if_msghdr ifm;
+	const struct sockaddr_dl *sdl;
 	char 		*buf, *next, *lim;
 	int 		 mib[6];
 	size_t 		 need, up;
@@ -550,6 +720,8 @@ sysinfo_update_if(struct sysinfo *p)
 	}
 
 	memset(&p->ifsum, 0, sizeof(p->ifsum));
+	p->nettxerr = p->netrxerr = p->netcoll = 0.0;
+	p->ifdevsz = 0;
 
 	lim = buf + need;
 	for (next = buf; next < lim; next += ifm.ifm_msglen) {
@@ -579,6 +751,15 @@ sysinfo_update_if(struct sysinfo *p)
 
 		ifs = &p->ifstats[ifm.ifm_index];
 
+		/* The link address, with the name, comes first. */
+
+		sdl = (const struct sockaddr_dl *)(next + ifm.ifm_hdrlen);
+		if (AF_LINK == sdl->sdl_family && 
+		    sdl->sdl_nlen < sizeof(ifs->ifs_name)) {
+			memcpy(ifs->ifs_name, sdl->sdl_data, sdl->sdl_nlen);
+			ifs->ifs_name[sdl->sdl_nlen] = '\0';
+		}
+
 		/* Only consider non-loopback up addresses. */
 
 		up = (ifs->ifs_cur.ifc_flags & IFF_UP) &&
@@ -586,15 +767,22 @@ sysinfo_update_if(struct sysinfo *p)
 
 		UPDATE(ifc_ip, ifm_data.ifi_ipackets, up);
 		UPDATE(ifc_ib, ifm_data.ifi_ibytes, up);
-		UPDATE(ifc_ie, ifm_data.ifi_ierrors, up);
+		UPDATE_REAL(ifc_ie, ifm_data.ifi_ierrors, up, p->netrxerr);
 		UPDATE(ifc_op, ifm_data.ifi_opackets, up);
 		UPDATE(ifc_ob, ifm_data.ifi_obytes, up);
-		UPDATE(ifc_oe, ifm_data.ifi_oerrors, up);
-		UPDATE(ifc_co, ifm_data.ifi_collisions, up);
+		UPDATE_REAL(ifc_oe, ifm_data.ifi_oerrors, up, p->nettxerr);
+		UPDATE_REAL(ifc_co, ifm_data.ifi_collisions, up, p->netcoll);
 
 		ifs->ifs_cur.ifc_flags = ifm.ifm_flags;
 		ifs->ifs_cur.ifc_state = ifm.ifm_data.ifi_link_state;
 		ifs->ifs_flag++;
+
+		if (up && ! sysdev_push(&p->ifdevs, &p->ifdevsz, 
+		    &p->ifdevmax, ifs->ifs_name, 
+		    ifs->ifs_cur.ifc_ib, ifs->ifs_cur.ifc_ob)) {
+			free(buf);
+			return 0;
+		}
 	}
 
 	free(buf);
@@ -605,10 +793,13 @@ static int
 sysinfo_update_disc(const struct syscfg *cfg, struct sysinfo *p)
 {
 	struct diskstats  q;
-	size_t		  i, need;
+	struct discstat	 *ds;
+	size_t		  i, n, need;
 	int		  mib[2];
 	char		 *buf, *lim, *next;
-	u_int64_t	  rb = 0, wb = 0;
+	u_int64_t	  rb = 0, wb = 0, xfer = 0;
+	struct timeval	  tv;
+	double		  ms, busy, maxbusy = 0.0, tms = 0.0;
 
 	mib[0] = CTL_HW;
 	mib[1] = HW_DISKSTATS;
@@ -625,8 +816,23 @@ sysinfo_update_disc(const struct syscfg *cfg, struct sysinfo *p)
 		return 0;
 	}
 
+	/* Keep the last counters of each disc by position. */
+
+	if (need / sizeof(q) > p->discstatsz) {
+		ds = recallocarray(p->discstats, p->discstatsz, 
+			need / sizeof(q), sizeof(struct discstat));
+		if (NULL == ds) {
+			warn(NULL);
+			free(buf);
+			return 0;
+		}
+		p->discstats = ds;
+		p->discstatsz = need / sizeof(q);
+	}
+
+	p->discdevsz = 0;
 	lim = buf + need;
-	for (next = buf; next < lim; next += sizeof(q)) {
+	for (n = 0, next = buf; next < lim; next += sizeof(q), n++) {
 		memcpy(&q, next, sizeof(q));
 		for (i = 0; i < cfg->discsz; i++)
 			if (0 == strcmp(cfg->discs[i], q.ds_name))
@@ -635,10 +841,57 @@ sysinfo_update_disc(const struct syscfg *cfg, struct sysinfo *p)
 			continue;
 		rb += q.ds_rbytes;
 		wb += q.ds_wbytes;
+
+		/* A different disc at this position starts afresh. */
+
+		ds = &p->discstats[n];
+		if (strcmp(ds->ds_name, q.ds_name)) {
+			strlcpy(ds->ds_name, q.ds_name, 
+				sizeof(ds->ds_name));
+			ds->ds_rbytes = q.ds_rbytes;
+			ds->ds_wbytes = q.ds_wbytes;
+			ds->ds_xfer = q.ds_rxfer + q.ds_wxfer;
+			ds->ds_time = q.ds_time;
+		}
+
+		/*
+		 * There's no per-transfer latency, so use the time busy
+		 * over the transfers completed (service time).
+		 * Utilisation is of the busiest disc.
+		 */
+
+		timersub(&q.ds_time, &ds->ds_time, &tv);
+		ms = tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+		if (q.ds_rxfer + q.ds_wxfer > ds->ds_xfer)
+			xfer += q.ds_rxfer + q.ds_wxfer - ds->ds_xfer;
+		if (ms > 0.0) {
+			tms += ms;
+			busy = p->elapsed > 0.0 ?
+				ms / (10.0 * p->elapsed) : 0.0;
+			if (busy > maxbusy)
+				maxbusy = busy;
+		}
+		ds->ds_xfer = q.ds_rxfer + q.ds_wxfer;
+		ds->ds_time = q.ds_time;
+		if ( ! sysdev_push(&p->discdevs, &p->discdevsz, 
+		    &p->discdevmax, q.ds_name,
+		    q.ds_rbytes > ds->ds_rbytes ?
+		    rate(p, q.ds_rbytes - ds->ds_rbytes) : 0,
+		    q.ds_wbytes > ds->ds_wbytes ?
+		    rate(p, q.ds_wbytes - ds->ds_wbytes) : 0)) {
+			free(buf);
+			return 0;
+		}
+		ds->ds_rbytes = q.ds_rbytes;
+		ds->ds_wbytes = q.ds_wbytes;
 	}
 
+	p->disc_iops = rate(p, xfer);
+	p->disc_await = xfer > 0 ? tms / xfer : 0.0;
+	p->disc_busy = maxbusy > 100.0 ? 100.0 : maxbusy;
+
 	if (rb > p->disc_rbytes) {
-		p->disc_ravg = (rb - p->disc_rbytes) / 15; 
+		p->disc_ravg = rate(p, rb - p->disc_rbytes);
 		p->disc_rbytes = rb;
 	} else {
 		p->disc_ravg = 0;
@@ -646,7 +899,7 @@ sysinfo_update_disc(const struct syscfg *cfg, struct sysinfo *p)
 	}
 
 	if (wb > p->disc_wbytes) {
-		p->disc_wavg = (wb - p->disc_wbytes) / 15; 
+		p->disc_wavg = rate(p, wb - p->disc_wbytes);
 		p->disc_wbytes = wb;
 	} else {
 		p->disc_wavg = 0;
@@ -657,24 +910,77 @@ sysinfo_update_disc(const struct syscfg *cfg, struct sysinfo *p)
 	return 1;
 }
 
+/*
+ * Sample each source that's due in this update, as given by its divisor
+ * in "cfg".
+ * If "cfg" is a burst (a sample between regular updates), only sources
+ * sampled at every update are due and the update isn't counted.
+ * Sources not due keep their last values.
+ * A source that fails is marked as stale (keeping its last values, too)
+ * and retried at its next turn.
+ * Rates are over the time since the source was last sampled.
+ * Return zero on failure, non-zero on success.
+ */
 int
 sysinfo_update(const struct syscfg *cfg, struct sysinfo *p)
 {
+	struct timespec	 now, start, end;
+	size_t		 i;
+	int		 rc;
 
-	if ( ! sysinfo_update_nprocs(cfg, p))
-		return 0;
-	if ( ! sysinfo_update_nfiles(cfg, p))
-		return 0;
-	if ( ! sysinfo_update_cpu(p))
-		return 0;
-	if ( ! sysinfo_update_mem(p))
-		return 0;
-	if ( ! sysinfo_update_if(p))
-		return 0;
-	if ( ! sysinfo_update_disc(cfg, p))
+	if (-1 == clock_gettime(CLOCK_MONOTONIC, &now)) {
+		warn("clock_gettime");
 		return 0;
+	}
 
-	p->sample++;
+	for (i = 0; i < SYSRC__MAX; i++) {
+		p->took[i] = -1.0;
+		if (cfg->divs[i] > 1 && 
+		    (cfg->burst || 0 != p->sample % cfg->divs[i]))
+			continue;
+		p->elapsed = 0 == p->last[i].tv_sec ? 0.0 :
+			(now.tv_sec - p->last[i].tv_sec) +
+			(now.tv_nsec - p->last[i].tv_nsec) /
+			1000000000.0;
+		if (-1 == clock_gettime(CLOCK_MONOTONIC, &start))
+			start = now;
+		switch (i) {
+		case SYSRC_CPU:
+			rc = sysinfo_update_cpu(p) &&
+				sysinfo_update_sched(p);
+			break;
+		case SYSRC_MEM:
+			rc = sysinfo_update_mem(p);
+			break;
+		case SYSRC_NET:
+			rc = sysinfo_update_if(p);
+			break;
+		case SYSRC_DISC:
+			rc = sysinfo_update_disc(cfg, p);
+			break;
+		case SYSRC_PROCS:
+			rc = sysinfo_update_nprocs(cfg, p);
+			break;
+		case SYSRC_RPROCS:
+			rc = sysinfo_update_rprocs(cfg, p);
+			break;
+		case SYSRC_FILES:
+			rc = sysinfo_update_nfiles(cfg, p);
+			break;
+		default:
+			abort();
+		}
+		if (0 == clock_gettime(CLOCK_MONOTONIC, &end))
+			p->took[i] = (end.tv_sec - start.tv_sec) +
+				(end.tv_nsec - start.tv_nsec) / 
+				1000000000.0;
+		if ((p->stale[i] = ! rc))
+			continue;
+		p->last[i] = now;
+	}
+
+	if ( ! cfg->burst)
+		p->sample++;
 	return 1;
 }
 
@@ -710,6 +1016,51 @@ sysinfo_get_netrx_avg(const struct sysinfo *p)
 	return p->ifsum.ifc_ib;
 }
 
+int64_t
+sysinfo_get_nettxpkt_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0;
+	return p->ifsum.ifc_op;
+}
+
+int64_t
+sysinfo_get_netrxpkt_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0;
+	return p->ifsum.ifc_ip;
+}
+
+double
+sysinfo_get_nettxerr_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0.0;
+	return p->nettxerr;
+}
+
+double
+sysinfo_get_netrxerr_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0.0;
+	return p->netrxerr;
+}
+
+double
+sysinfo_get_netcoll_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0.0;
+	return p->netcoll;
+}
+
 int64_t
 sysinfo_get_discread_avg(const struct sysinfo *p)
 {
@@ -728,6 +1079,103 @@ sysinfo_get_discwrite_avg(const struct sysinfo *p)
 	return p->disc_wavg;
 }
 
+int64_t
+sysinfo_get_disciops_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0;
+	return p->disc_iops;
+}
+
+double
+sysinfo_get_discawait_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0.0;
+	return p->disc_await;
+}
+
+double
+sysinfo_get_discbusy_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0.0;
+	return p->disc_busy;
+}
+
+int64_t
+sysinfo_get_ctxt_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0;
+	return p->ctxt_avg;
+}
+
+int64_t
+sysinfo_get_intr_avg(const struct sysinfo *p)
+{
+
+	if (1 == p->sample)
+		return 0;
+	return p->intr_avg;
+}
+
+double
+sysinfo_get_procsrun(const struct sysinfo *p)
+{
+
+	return p->procs_run;
+}
+
+double
+sysinfo_get_procsblk(const struct sysinfo *p)
+{
+
+	return p->procs_blk;
+}
+
+double
+sysinfo_get_load1(const struct sysinfo *p)
+{
+
+	return p->load[0];
+}
+
+double
+sysinfo_get_load5(const struct sysinfo *p)
+{
+
+	return p->load[1];
+}
+
+double
+sysinfo_get_load15(const struct sysinfo *p)
+{
+
+	return p->load[2];
+}
+
+/*
+ * There's no pressure stall information.
+ */
+double
+sysinfo_get_psi_some(const struct sysinfo *p, enum psirc r)
+{
+
+	return 0.0;
+}
+
+double
+sysinfo_get_psi_full(const struct sysinfo *p, enum psirc r)
+{
+
+	return 0.0;
+}
+
 double
 sysinfo_get_rprocs(const struct sysinfo *p)
 {
@@ -755,4 +1203,50 @@ sysinfo_get_boottime(const struct sysinfo *p)
 
 	return p->boottime;
 }
+
+size_t
+sysinfo_get_cores(const struct sysinfo *p, const uint16_t **v)
+{
+
+	*v = p->corepm;
+	return p->ncpu;
+}
+
+size_t
+sysinfo_get_ifs(const struct sysinfo *p, const struct sysdev **v)
+{
+
+	*v = p->ifdevs;
+	return p->ifdevsz;
+}
+
+size_t
+sysinfo_get_discs(const struct sysinfo *p, const struct sysdev **v)
+{
+
+	*v = p->discdevs;
+	return p->discdevsz;
+}
+
+size_t
+sysinfo_get_metrics(const struct sysinfo *p, const struct sysmetric **v)
+{
+
+	*v = p->metrics;
+	return SYSMET__MAX;
+}
+
+int
+sysinfo_get_stale(const struct sysinfo *p, enum sysrc src)
+{
+
+	return p->stale[src];
+}
+
+double
+sysinfo_get_took(const struct sysinfo *p, enum sysrc src)
+{
+
+	return p->took[src];
+}
 #endif
@@ -20,81 +20,1947 @@
 # include <sys/queue.h>
 #endif
 #include <sys/utsname.h>
+#ifdef __linux__
+# include <sys/timerfd.h>
+#endif
+
+#include <assert.h>
+#if HAVE_ERR
+# include <err.h>
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <paths.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sqlite3.h>
+
+#include "slant-collectd.h"
+#include "slant-summary.h"
+#include "extern.h"
+#include "db.h"
+#include "slant-chunk.h"
+#include "slant-ring.h"
+#include "slant-rollup.h"
+
+#ifndef _PATH_VAREMPTY
+# define _PATH_VAREMPTY "/var/empty"
+#endif
+
+static	sig_atomic_t	doexit = 0;
+
+/*
+ * Names of sources for the -s spec and verbose output.
+ */
+static	const char *const sysrcs[SYSRC__MAX] = {
+	"cpu", /* SYSRC_CPU */
+	"mem", /* SYSRC_MEM */
+	"net", /* SYSRC_NET */
+	"disc", /* SYSRC_DISC */
+	"procs", /* SYSRC_PROCS */
+	"rprocs", /* SYSRC_RPROCS */
+	"files", /* SYSRC_FILES */
+};
+
+static void
+sig(int sig)
+{
+
+	doexit = 1;
+}
+
+/*
+ * Per-core processor time in permille: either of a single sample or,
+ * within a tier, summed over the samples of its newest record.
+ */
+struct	coreset {
+	double		*v; /* per-core values */
+	size_t		 sz; /* number of cores */
+	size_t		 max; /* allocated size of v */
+};
+
+/*
+ * Per-device rates of one kind (interfaces or discs) by name, summed
+ * like the coreset.
+ */
+struct	devset {
+	struct sysdev	*v; /* devices */
+	size_t		 sz; /* number of devices */
+	size_t		 max; /* allocated size of v */
+};
+
+/*
+ * Values of the backend's metrics (see sysinfo_get_metrics()) by their
+ * database identifier, summed like the coreset.
+ */
+struct	metricval {
+	int64_t		 id; /* metric identifier */
+	double		 v; /* value */
+};
+
+struct	metricset {
+	struct metricval *v; /* metrics */
+	size_t		 sz; /* number of metrics */
+	size_t		 max; /* allocated size of v */
+};
+
+/*
+ * Version of the encoding in metricset_encode().
+ */
+#define	METRICSET_VERSION 1
+
+/*
+ * What's kept of a sample or record beside its record columns: the
+ * summary, per-core times, per-device rates, and metrics.
+ */
+struct	detail {
+	struct summary	 sum; /* summary of the samples */
+	struct coreset	 cores; /* per-core times */
+	struct devset	 ifs; /* per-interface rates */
+	struct devset	 discs; /* per-disc rates */
+	struct metricset metrics; /* metrics by identifier */
+};
+
+/*
+ * In-memory state of one interval's records.
+ * This is loaded from the database once at startup and kept in sync
+ * with what we write, so we needn't re-read the table each sample.
+ */
+struct	tier {
+	enum interval	 ival; /* record type */
+	time_t		 span; /* seconds per record or 0 (per sample) */
+	size_t		 allowed; /* records to keep before recycling */
+	int64_t		*ids; /* ring of record ids, oldest first */
+	size_t		 idsz; /* number of records (if ring, 1 if head) */
+	size_t		 idmax; /* allocated size of ids */
+	size_t		 idstart; /* position of oldest in ids */
+	struct record	 head; /* copy of newest record if idsz */
+	struct detail	 det; /* detail of head's samples */
+	int		 dirty; /* head not yet written */
+	int		 seal; /* start a new record next sample */
+	int		 archive; /* pack completed records */
+	struct record	*chunk; /* completed records not yet packed */
+	size_t		 chunksz; /* number of records in chunk */
+	size_t		 chunkmax; /* records per chunk */
+	time_t		 chunklast; /* ctime of newest packed record */
+	struct ring	*ring; /* if set, kept there, not in database */
+};
+
+#define	TIER_SEC 6 /* burst tier, not in regular updates */
+#define	TIER__MAX 7
+
+/*
+ * Default retention of each interval.
+ * We keep one more record than "allowed", as the newest is always the
+ * one being accumulated.
+ * Zero means that the interval is unbounded.
+ */
+static	const struct tierdef {
+	const char	*name; /* for the -r spec */
+	enum interval	 ival;
+	time_t		 span;
+	size_t		 allowed;
+} tierdefs[TIER__MAX] = {
+	/* 40 (10 minute) backlog of quarter-minute entries. */
+	{ "qmin", INTERVAL_byqmin, 0, 4 * 10 },
+	/* 300 (5 hours) backlog of by-minute entries. */
+	{ "min", INTERVAL_bymin, 60, 60 * 5 },
+	/* 120 (5 days) backlog of by-hour entries. */
+	{ "hour", INTERVAL_byhour, 60 * 60, 24 * 5 },
+	/* 28 (4 weeks) backlog of by-day entries. */
+	{ "day", INTERVAL_byday, 60 * 60 * 24, 7 * 4 },
+	/* 104 (two year) backlog of by-week entries. */
+	{ "week", INTERVAL_byweek, 60 * 60 * 24 * 7, 52 * 2 },
+	/* Endless backlog of yearly entries. */
+	{ "year", INTERVAL_byyear, 60 * 60 * 24 * 365, 0 },
+	/* 300 (5 minutes) backlog of burst per-second entries. */
+	{ "sec", INTERVAL_bysec, 0, 60 * 5 },
+};
+
+/*
+ * Burst sampling: when a sample crosses a threshold, sample every
+ * second until "window" seconds pass without crossing it again.
+ * These samples go into the per-second tier, and their average makes
+ * up the regular sample.
+ */
+/*
+ * A burst sample waiting to be written.
+ */
+struct	pending {
+	time_t		 t; /* when sampled */
+	struct record	 rec; /* the sample */
+	struct detail	 det; /* its detail */
+};
+
+struct	burst {
+	double		 cpu; /* cpu percentage threshold or 0 */
+	int64_t		 disc; /* disc bytes/second threshold or 0 */
+	time_t		 window; /* seconds to sample after crossing */
+	time_t		 end; /* when the current burst ends */
+	struct record	 acc; /* samples since the last regular one */
+	struct detail	 det; /* detail of "acc" */
+	struct pending	*pend; /* samples not yet written */
+	size_t		 pendsz; /* number of pending samples */
+	size_t		 pendmax; /* allocated pending samples */
+};
+
+#define	STAGE_BUCKETS 32
+
+/*
+ * Stages of sampling whose durations we keep: first each source, in
+ * the order of enum sysrc, then our own.
+ */
+enum	stageid {
+	STAGE_TIERS = SYSRC__MAX, /* updating the tiers */
+	STAGE_COMMIT, /* committing to the database */
+	STAGE_LATE, /* waking after the deadline */
+	STAGE__MAX
+};
+
+static	const char *const stages[STAGE__MAX] = {
+	"cpu", /* SYSRC_CPU */
+	"mem", /* SYSRC_MEM */
+	"net", /* SYSRC_NET */
+	"disc", /* SYSRC_DISC */
+	"procs", /* SYSRC_PROCS */
+	"rprocs", /* SYSRC_RPROCS */
+	"files", /* SYSRC_FILES */
+	"tiers", /* STAGE_TIERS */
+	"commit", /* STAGE_COMMIT */
+	"late", /* STAGE_LATE */
+};
+
+/*
+ * Histogram of a stage's durations in buckets of doubling
+ * microseconds: bucket zero is under one, then bucket k is from
+ * 2^(k-1) up to 2^k, the last also holding anything longer.
+ */
+struct	stagehist {
+	uint64_t	 count; /* number of durations */
+	double		 sum; /* total seconds */
+	double		 max; /* longest seconds */
+	uint64_t	 bucket[STAGE_BUCKETS];
+};
+
+struct	stages {
+	struct stagehist hist[STAGE__MAX];
+	time_t		 since; /* when we started */
+};
+
+/*
+ * Make room for at least "sz" cores, zeroing any new ones.
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+coreset_grow(struct coreset *c, size_t sz)
+{
+	void	*pp;
+	size_t	 i;
+
+	if (sz > c->max) {
+		if (NULL == (pp = reallocarray(c->v, sz, sizeof(double)))) {
+			warn(NULL);
+			return 0;
+		}
+		c->v = pp;
+		c->max = sz;
+	}
+	for (i = c->sz; i < sz; i++)
+		c->v[i] = 0.0;
+	if (sz > c->sz)
+		c->sz = sz;
+	return 1;
+}
+
+/*
+ * Add the values of "src" to those of "dst".
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+coreset_add(struct coreset *dst, const struct coreset *src)
+{
+	size_t	 i;
+
+	if ( ! coreset_grow(dst, src->sz))
+		return 0;
+	for (i = 0; i < src->sz; i++)
+		dst->v[i] += src->v[i];
+	return 1;
+}
+
+static void
+coreset_scale(struct coreset *c, double f)
+{
+	size_t	 i;
+
+	for (i = 0; i < c->sz; i++)
+		c->v[i] *= f;
+}
+
+/*
+ * Set "c" from the per-core times of the current sample.
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+coreset_sample(struct coreset *c, const struct sysinfo *p)
+{
+	const uint16_t	*v;
+	size_t		 i, sz;
+
+	sz = sysinfo_get_cores(p, &v);
+	c->sz = 0;
+	if ( ! coreset_grow(c, sz))
+		return 0;
+	for (i = 0; i < sz; i++)
+		c->v[i] = v[i];
+	return 1;
+}
+
+/*
+ * Serialise the averages of "c" over "entries" samples as in the
+ * "cores" record field.
+ * Returns NULL if there are no cores or on memory failure.
+ */
+static void *
+coreset_encode(const struct coreset *c, int64_t entries, size_t *sz)
+{
+	unsigned char	*buf;
+	size_t		 i;
+	double		 v;
+
+	*sz = 0;
+	if (0 == c->sz || entries <= 0)
+		return NULL;
+	if (NULL == (buf = reallocarray(NULL, c->sz, 2))) {
+		warn(NULL);
+		return NULL;
+	}
+	for (i = 0; i < c->sz; i++) {
+		v = c->v[i] / entries + 0.5;
+		v = v > 1000.0 ? 1000.0 : v < 0.0 ? 0.0 : v;
+		buf[i * 2] = (unsigned int)v & 0xff;
+		buf[i * 2 + 1] = (unsigned int)v >> 8;
+	}
+	*sz = c->sz * 2;
+	return buf;
+}
+
+/*
+ * Parse a "cores" field of a record with "entries" samples back into
+ * sums.
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+coreset_decode(struct coreset *c, 
+	const void *p, size_t sz, int64_t entries)
+{
+	const unsigned char *buf = p;
+	size_t		 i;
+
+	c->sz = 0;
+	if ( ! coreset_grow(c, sz / 2))
+		return 0;
+	for (i = 0; i < sz / 2; i++)
+		c->v[i] = (buf[i * 2] | (buf[i * 2 + 1] << 8)) * 
+			(double)entries;
+	return 1;
+}
+
+/*
+ * Add the rates of devices "v" to those of the same name in "dst",
+ * appending those not yet in it.
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+devset_add(struct devset *dst, const struct sysdev *v, size_t sz)
+{
+	void	*pp;
+	size_t	 i, j;
+
+	for (i = 0; i < sz; i++) {
+		for (j = 0; j < dst->sz; j++)
+			if (0 == strcmp(dst->v[j].name, v[i].name))
+				break;
+		if (j < dst->sz) {
+			dst->v[j].rx += v[i].rx;
+			dst->v[j].tx += v[i].tx;
+			continue;
+		}
+		if (dst->sz == dst->max) {
+			pp = reallocarray(dst->v, 
+				dst->max + 8, sizeof(struct sysdev));
+			if (NULL == pp) {
+				warn(NULL);
+				return 0;
+			}
+			dst->v = pp;
+			dst->max += 8;
+		}
+		dst->v[dst->sz++] = v[i];
+	}
+	return 1;
+}
+
+static void
+devset_scale(struct devset *d, double f)
+{
+	size_t	 i;
+
+	for (i = 0; i < d->sz; i++) {
+		d->v[i].rx *= f;
+		d->v[i].tx *= f;
+	}
+}
+
+/*
+ * Add the values of "v" to those of the same identifier in "dst",
+ * appending those not yet in it.
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+metricset_add(struct metricset *dst, const struct metricval *v, size_t sz)
+{
+	void	*pp;
+	size_t	 i, j;
+
+	for (i = 0; i < sz; i++) {
+		for (j = 0; j < dst->sz; j++)
+			if (dst->v[j].id == v[i].id)
+				break;
+		if (j < dst->sz) {
+			dst->v[j].v += v[i].v;
+			continue;
+		}
+		if (dst->sz == dst->max) {
+			pp = reallocarray(dst->v, 
+				dst->max + 8, sizeof(struct metricval));
+			if (NULL == pp) {
+				warn(NULL);
+				return 0;
+			}
+			dst->v = pp;
+			dst->max += 8;
+		}
+		dst->v[dst->sz++] = v[i];
+	}
+	return 1;
+}
+
+static void
+metricset_scale(struct metricset *m, double f)
+{
+	size_t	 i;
+
+	for (i = 0; i < m->sz; i++)
+		m->v[i].v *= f;
+}
+
+/*
+ * Serialise "m" as in the "metrics" record field.
+ * Returns NULL if there are no metrics or on memory failure.
+ */
+static void *
+metricset_encode(const struct metricset *m, size_t *sz)
+{
+	unsigned char	*buf;
+	uint64_t	 v;
+	size_t		 i, j, pos = 0;
+
+	*sz = 0;
+	if (0 == m->sz)
+		return NULL;
+
+	/* Version, count, then 10-byte varint and double each. */
+
+	if (NULL == (buf = malloc(1 + 10 + m->sz * 18))) {
+		warn(NULL);
+		return NULL;
+	}
+
+	buf[pos++] = METRICSET_VERSION;
+	for (v = m->sz; v >= 0x80; v >>= 7)
+		buf[pos++] = (v & 0x7f) | 0x80;
+	buf[pos++] = v;
+	for (i = 0; i < m->sz; i++) {
+		for (v = m->v[i].id; v >= 0x80; v >>= 7)
+			buf[pos++] = (v & 0x7f) | 0x80;
+		buf[pos++] = v;
+		memcpy(&v, &m->v[i].v, sizeof(double));
+		for (j = 0; j < 8; j++)
+			buf[pos++] = v >> (j * 8);
+	}
+
+	*sz = pos;
+	return buf;
+}
+
+/*
+ * Read a varint from "buf" of size "sz" at "*pos".
+ * Return zero if truncated, non-zero on success.
+ */
+static int
+metricset_varint(const unsigned char *buf, 
+	size_t sz, size_t *pos, uint64_t *v)
+{
+	unsigned int	 shift;
+
+	for (*v = 0, shift = 0; *pos < sz && shift < 64; shift += 7) {
+		*v |= (uint64_t)(buf[*pos] & 0x7f) << shift;
+		if ( ! (buf[(*pos)++] & 0x80))
+			return 1;
+	}
+	return 0;
+}
+
+/*
+ * Parse a "metrics" field of a record back into "m".
+ * A malformed field or one of another version leaves "m" empty.
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+metricset_decode(struct metricset *m, const void *p, size_t sz)
+{
+	const unsigned char *buf = p;
+	struct metricval mv;
+	uint64_t	 n, v;
+	size_t		 i, j, pos = 1;
+
+	m->sz = 0;
+	if (0 == sz || METRICSET_VERSION != buf[0] ||
+	    ! metricset_varint(buf, sz, &pos, &n))
+		return 1;
+
+	for (i = 0; i < n; i++) {
+		if ( ! metricset_varint(buf, sz, &pos, &v) ||
+		    sz - pos < 8) {
+			m->sz = 0;
+			return 1;
+		}
+		mv.id = v;
+		for (v = 0, j = 0; j < 8; j++)
+			v |= (uint64_t)buf[pos++] << (j * 8);
+		memcpy(&mv.v, &v, sizeof(double));
+		if ( ! metricset_add(m, &mv, 1))
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * Empty "d", keeping its memory.
+ */
+static void
+detail_clear(struct detail *d)
+{
+
+	summary_init(&d->sum);
+	d->cores.sz = 0;
+	d->ifs.sz = 0;
+	d->discs.sz = 0;
+	d->metrics.sz = 0;
+}
+
+/*
+ * Merge the detail "src" into "dst".
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+detail_add(struct detail *dst, const struct detail *src)
+{
+
+	summary_merge(&dst->sum, &src->sum);
+	return coreset_add(&dst->cores, &src->cores) &&
+	    devset_add(&dst->ifs, src->ifs.v, src->ifs.sz) &&
+	    devset_add(&dst->discs, src->discs.v, src->discs.sz) &&
+	    metricset_add(&dst->metrics, 
+		src->metrics.v, src->metrics.sz);
+}
+
+/*
+ * Scale the sums in "d" (but not its summary, which stays whole).
+ */
+static void
+detail_scale(struct detail *d, double f)
+{
+
+	coreset_scale(&d->cores, f);
+	devset_scale(&d->ifs, f);
+	devset_scale(&d->discs, f);
+	metricset_scale(&d->metrics, f);
+}
+
+static void
+detail_free(struct detail *d)
+{
+
+	free(d->cores.v);
+	free(d->ifs.v);
+	free(d->discs.v);
+	free(d->metrics.v);
+}
+
+/*
+ * Look up the device "name" among the "sz" devices "v".
+ * Returns NULL if not found.
+ */
+static const struct sysdev *
+devset_find(const struct sysdev *v, size_t sz, const char *name)
+{
+	size_t	 i;
+
+	for (i = 0; i < sz; i++)
+		if (0 == strcmp(v[i].name, name))
+			return &v[i];
+	return NULL;
+}
+
+/*
+ * Write the per-device rows of record "id" from "d".
+ * If "replace" is set, the record already has rows: these are updated
+ * in place if their rates have changed, and only rows of devices that
+ * have come or gone are inserted or deleted.
+ */
+static void
+devices_write(struct ort *db, int64_t id, 
+	const struct detail *d, int replace)
+{
+	struct ifrecord_q	*iq = NULL;
+	struct discrecord_q	*dq = NULL;
+	const struct ifrecord	*ir;
+	const struct discrecord	*dr;
+	const struct sysdev	*v;
+	size_t			 i;
+
+	if (replace) {
+		if (NULL == (iq = db_ifrecord_list_record(db, id)))
+			return;
+		TAILQ_FOREACH(ir, iq, _entries) {
+			v = devset_find(d->ifs.v, d->ifs.sz, ir->name);
+			if (NULL == v)
+				db_ifrecord_delete_dev(db, id, ir->name);
+			else if (v->tx != ir->nettx || v->rx != ir->netrx)
+				db_ifrecord_update_dev(db, 
+					v->tx, v->rx, id, ir->name);
+		}
+	}
+	for (i = 0; i < d->ifs.sz; i++) {
+		v = &d->ifs.v[i];
+		if (NULL != iq)
+			TAILQ_FOREACH(ir, iq, _entries)
+				if (0 == strcmp(ir->name, v->name))
+					break;
+		if (NULL == iq || NULL == ir)
+			db_ifrecord_insert(db, id, v->name, v->tx, v->rx);
+	}
+	if (NULL != iq)
+		db_ifrecord_freeq(iq);
+
+	if (replace) {
+		if (NULL == (dq = db_discrecord_list_record(db, id)))
+			return;
+		TAILQ_FOREACH(dr, dq, _entries) {
+			v = devset_find(d->discs.v, d->discs.sz, dr->name);
+			if (NULL == v)
+				db_discrecord_delete_dev(db, id, dr->name);
+			else if (v->rx != dr->discread || 
+			    v->tx != dr->discwrite)
+				db_discrecord_update_dev(db, 
+					v->rx, v->tx, id, dr->name);
+		}
+	}
+	for (i = 0; i < d->discs.sz; i++) {
+		v = &d->discs.v[i];
+		if (NULL != dq)
+			TAILQ_FOREACH(dr, dq, _entries)
+				if (0 == strcmp(dr->name, v->name))
+					break;
+		if (NULL == dq || NULL == dr)
+			db_discrecord_insert(db, id, v->name, v->rx, v->tx);
+	}
+	if (NULL != dq)
+		db_discrecord_freeq(dq);
+}
+
+/*
+ * Read the per-device rows of record "id" back into "d".
+ * Return zero on failure, non-zero on success.
+ */
+static int
+devices_read(struct ort *db, int64_t id, struct detail *d)
+{
+	struct ifrecord_q	*iq;
+	struct discrecord_q	*dq;
+	const struct ifrecord	*ir;
+	const struct discrecord	*dr;
+	struct sysdev		 v;
+	int			 rc = 1;
+
+	d->ifs.sz = d->discs.sz = 0;
+	memset(&v, 0, sizeof(struct sysdev));
+
+	if (NULL == (iq = db_ifrecord_list_record(db, id)))
+		return 0;
+	TAILQ_FOREACH(ir, iq, _entries) {
+		strlcpy(v.name, ir->name, sizeof(v.name));
+		v.rx = ir->netrx;
+		v.tx = ir->nettx;
+		if ( ! (rc = devset_add(&d->ifs, &v, 1)))
+			break;
+	}
+	db_ifrecord_freeq(iq);
+	if ( ! rc)
+		return 0;
+
+	if (NULL == (dq = db_discrecord_list_record(db, id)))
+		return 0;
+	TAILQ_FOREACH(dr, dq, _entries) {
+		strlcpy(v.name, dr->name, sizeof(v.name));
+		v.rx = dr->discread;
+		v.tx = dr->discwrite;
+		if ( ! (rc = devset_add(&d->discs, &v, 1)))
+			break;
+	}
+	db_discrecord_freeq(dq);
+	return rc;
+}
+
+/*
+ * Wrappers around the generated record functions so that each call
+ * site needn't list every field, also writing the per-device rows.
+ * If the summary, cores, or metrics can't be encoded, they're written
+ * as null.
+ */
+static int64_t
+record_insert(struct ort *db, time_t ctime, enum interval ival, 
+	const struct record *r, const struct detail *d)
+{
+	const void	*buf, *cbuf, *mbuf;
+	size_t		 sz = 0, csz, msz;
+	int64_t		 id;
+
+	if (NULL == (buf = summary_encode(&d->sum, &sz)))
+		warn(NULL);
+	cbuf = coreset_encode(&d->cores, r->entries, &csz);
+	mbuf = metricset_encode(&d->metrics, &msz);
+	id = db_record_insert(db, ctime, r->entries, 
+		r->cpu, r->mem, r->nettx, r->netrx,
+		r->nettxpkt, r->netrxpkt, r->nettxerr,
+		r->netrxerr, r->netcoll, r->discread,
+		r->discwrite, r->disciops, r->discawait,
+		r->discbusy, r->nprocs, r->rprocs, r->nfiles, 
+		r->ctxt, r->intr, r->procsrun, r->procsblk,
+		r->load1, r->load5, r->load15,
+		r->psicpusome, r->psicpufull, r->psimemsome,
+		r->psimemfull, r->psiiosome, r->psiiofull,
+		sz, NULL == buf ? NULL : &buf, 
+		csz, NULL == cbuf ? NULL : &cbuf, 
+		msz, NULL == mbuf ? NULL : &mbuf, ival);
+	if (-1 != id)
+		devices_write(db, id, d, 0);
+	free((void *)buf);
+	free((void *)cbuf);
+	free((void *)mbuf);
+	return id;
+}
+
+static void
+record_update_tail(struct ort *db, time_t ctime, 
+	const struct record *r, const struct detail *d, int64_t id)
+{
+	const void	*buf, *cbuf, *mbuf;
+	size_t		 sz = 0, csz, msz;
+
+	if (NULL == (buf = summary_encode(&d->sum, &sz)))
+		warn(NULL);
+	cbuf = coreset_encode(&d->cores, r->entries, &csz);
+	mbuf = metricset_encode(&d->metrics, &msz);
+	db_record_update_tail(db, ctime, r->entries, 
+		r->cpu, r->mem, r->nettx, r->netrx,
+		r->nettxpkt, r->netrxpkt, r->nettxerr,
+		r->netrxerr, r->netcoll, r->discread,
+		r->discwrite, r->disciops, r->discawait,
+		r->discbusy, r->nprocs, r->rprocs, r->nfiles, 
+		r->ctxt, r->intr, r->procsrun, r->procsblk,
+		r->load1, r->load5, r->load15,
+		r->psicpusome, r->psicpufull, r->psimemsome,
+		r->psimemfull, r->psiiosome, r->psiiofull,
+		sz, NULL == buf ? NULL : &buf, 
+		csz, NULL == cbuf ? NULL : &cbuf, 
+		msz, NULL == mbuf ? NULL : &mbuf, id);
+	devices_write(db, id, d, 1);
+	free((void *)buf);
+	free((void *)cbuf);
+	free((void *)mbuf);
+}
+
+static void
+record_update_current(struct ort *db, 
+	const struct record *r, const struct detail *d, int64_t id)
+{
+	const void	*buf, *cbuf, *mbuf;
+	size_t		 sz = 0, csz, msz;
+
+	if (NULL == (buf = summary_encode(&d->sum, &sz)))
+		warn(NULL);
+	cbuf = coreset_encode(&d->cores, r->entries, &csz);
+	mbuf = metricset_encode(&d->metrics, &msz);
+	db_record_update_current(db, r->entries, 
+		r->cpu, r->mem, r->nettx, r->netrx,
+		r->nettxpkt, r->netrxpkt, r->nettxerr,
+		r->netrxerr, r->netcoll, r->discread,
+		r->discwrite, r->disciops, r->discawait,
+		r->discbusy, r->nprocs, r->rprocs, r->nfiles, 
+		r->ctxt, r->intr, r->procsrun, r->procsblk,
+		r->load1, r->load5, r->load15,
+		r->psicpusome, r->psicpufull, r->psimemsome,
+		r->psimemfull, r->psiiosome, r->psiiofull,
+		sz, NULL == buf ? NULL : &buf, 
+		csz, NULL == cbuf ? NULL : &cbuf, 
+		msz, NULL == mbuf ? NULL : &mbuf, id);
+	devices_write(db, id, d, 1);
+	free((void *)buf);
+	free((void *)cbuf);
+	free((void *)mbuf);
+}
+
+/*
+ * Summarise the single sample "r" into "s".
+ */
+static void
+record_summary(const struct record *r, struct summary *s)
+{
+
+	summary_init(s);
+	summary_add(s, SUMMET_CPU, r->cpu);
+	summary_add(s, SUMMET_MEM, r->mem);
+	summary_add(s, SUMMET_NETTX, r->nettx);
+	summary_add(s, SUMMET_NETRX, r->netrx);
+	summary_add(s, SUMMET_DISCREAD, r->discread);
+	summary_add(s, SUMMET_DISCWRITE, r->discwrite);
+	summary_add(s, SUMMET_NPROCS, r->nprocs);
+	summary_add(s, SUMMET_RPROCS, r->rprocs);
+	summary_add(s, SUMMET_NFILES, r->nfiles);
+	summary_add(s, SUMMET_NETTXPKT, r->nettxpkt);
+	summary_add(s, SUMMET_NETRXPKT, r->netrxpkt);
+	summary_add(s, SUMMET_NETTXERR, r->nettxerr);
+	summary_add(s, SUMMET_NETRXERR, r->netrxerr);
+	summary_add(s, SUMMET_NETCOLL, r->netcoll);
+	summary_add(s, SUMMET_DISCIOPS, r->disciops);
+	summary_add(s, SUMMET_DISCAWAIT, r->discawait);
+	summary_add(s, SUMMET_DISCBUSY, r->discbusy);
+	summary_add(s, SUMMET_CTXT, r->ctxt);
+	summary_add(s, SUMMET_INTR, r->intr);
+	summary_add(s, SUMMET_PROCSRUN, r->procsrun);
+	summary_add(s, SUMMET_PROCSBLK, r->procsblk);
+	summary_add(s, SUMMET_LOAD1, r->load1);
+	summary_add(s, SUMMET_LOAD5, r->load5);
+	summary_add(s, SUMMET_LOAD15, r->load15);
+	summary_add(s, SUMMET_PSICPUSOME, r->psicpusome);
+	summary_add(s, SUMMET_PSICPUFULL, r->psicpufull);
+	summary_add(s, SUMMET_PSIMEMSOME, r->psimemsome);
+	summary_add(s, SUMMET_PSIMEMFULL, r->psimemfull);
+	summary_add(s, SUMMET_PSIIOSOME, r->psiiosome);
+	summary_add(s, SUMMET_PSIIOFULL, r->psiiofull);
+}
+
+/*
+ * Turn the accumulated samples "acc" into a single averaged sample
+ * "dst".
+ */
+static void
+record_avg(struct record *dst, const struct record *acc)
+{
+
+	assert(acc->entries > 0);
+	memset(dst, 0, sizeof(struct record));
+	dst->entries = 1;
+	dst->cpu = acc->cpu / acc->entries;
+	dst->mem = acc->mem / acc->entries;
+	dst->nettx = acc->nettx / acc->entries;
+	dst->netrx = acc->netrx / acc->entries;
+	dst->nettxpkt = acc->nettxpkt / acc->entries;
+	dst->netrxpkt = acc->netrxpkt / acc->entries;
+	dst->nettxerr = acc->nettxerr / acc->entries;
+	dst->netrxerr = acc->netrxerr / acc->entries;
+	dst->netcoll = acc->netcoll / acc->entries;
+	dst->discread = acc->discread / acc->entries;
+	dst->discwrite = acc->discwrite / acc->entries;
+	dst->disciops = acc->disciops / acc->entries;
+	dst->discawait = acc->discawait / acc->entries;
+	dst->discbusy = acc->discbusy / acc->entries;
+	dst->nprocs = acc->nprocs / acc->entries;
+	dst->rprocs = acc->rprocs / acc->entries;
+	dst->nfiles = acc->nfiles / acc->entries;
+	dst->ctxt = acc->ctxt / acc->entries;
+	dst->intr = acc->intr / acc->entries;
+	dst->procsrun = acc->procsrun / acc->entries;
+	dst->procsblk = acc->procsblk / acc->entries;
+	dst->load1 = acc->load1 / acc->entries;
+	dst->load5 = acc->load5 / acc->entries;
+	dst->load15 = acc->load15 / acc->entries;
+	dst->psicpusome = acc->psicpusome / acc->entries;
+	dst->psicpufull = acc->psicpufull / acc->entries;
+	dst->psimemsome = acc->psimemsome / acc->entries;
+	dst->psimemfull = acc->psimemfull / acc->entries;
+	dst->psiiosome = acc->psiiosome / acc->entries;
+	dst->psiiofull = acc->psiiofull / acc->entries;
+}
+
+/*
+ * Append a new newest record id to the tier.
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+tier_push(struct tier *t, int64_t id)
+{
+	int64_t	*pp;
+	size_t	 i, max;
+
+	if (t->idsz == t->idmax) {
+		max = 0 == t->idmax ? 64 : t->idmax * 2;
+		if (NULL == (pp = reallocarray(NULL, max, sizeof(int64_t)))) {
+			warn(NULL);
+			return 0;
+		}
+		for (i = 0; i < t->idsz; i++)
+			pp[i] = t->ids[(t->idstart + i) % t->idmax];
+		free(t->ids);
+		t->ids = pp;
+		t->idmax = max;
+		t->idstart = 0;
+	}
+
+	t->ids[(t->idstart + t->idsz) % t->idmax] = id;
+	t->idsz++;
+	return 1;
+}
+
+/*
+ * Set the default retention of all tiers.
+ */
+static void
+tiers_init(struct tier *tiers)
+{
+	size_t	 i;
+
+	for (i = 0; i < TIER__MAX; i++) {
+		tiers[i].ival = tierdefs[i].ival;
+		tiers[i].span = tierdefs[i].span;
+		tiers[i].allowed = 0 == tierdefs[i].allowed ?
+			SIZE_MAX : tierdefs[i].allowed;
+	}
+}
+
+/*
+ * Parse a retention spec "name=depth[,name=depth...]", with names as
+ * in "tierdefs", into the allowed records of each tier.
+ * A depth of zero means unbounded.
+ * Return zero on failure, non-zero on success.
+ */
+static int
+tiers_retention(struct tier *tiers, const char *spec)
+{
+	char		*cp, *tofree, *tok, *val;
+	const char	*er;
+	long long	 depth;
+	size_t		 i;
+	int		 rc = 0;
+
+	if (NULL == (tofree = cp = strdup(spec))) {
+		warn(NULL);
+		return 0;
+	}
+
+	while (NULL != (tok = strsep(&cp, ","))) {
+		if ('\0' == tok[0])
+			continue;
+		if (NULL == (val = strchr(tok, '='))) {
+			warnx("-r: %s: expected name=depth", tok);
+			goto out;
+		}
+		*val++ = '\0';
+		for (i = 0; i < TIER__MAX; i++)
+			if (0 == strcmp(tok, tierdefs[i].name))
+				break;
+		if (TIER__MAX == i) {
+			warnx("-r: %s: unknown interval", tok);
+			goto out;
+		}
+		depth = strtonum(val, 0, INT_MAX, &er);
+		if (NULL != er) {
+			warnx("-r: %s: %s", tok, er);
+			goto out;
+		}
+		tiers[i].allowed = 0 == depth ? SIZE_MAX : (size_t)depth;
+	}
+
+	rc = 1;
+out:
+	free(tofree);
+	return rc;
+}
+
+/*
+ * Parse an archive spec "name[,name...]", with names as in "tierdefs",
+ * into the tiers whose completed records are packed into chunks.
+ * Return zero on failure, non-zero on success.
+ */
+static int
+tiers_archive(struct tier *tiers, const char *spec)
+{
+	char		*cp, *tofree, *tok;
+	size_t		 i;
+	int		 rc = 0;
+
+	if (NULL == (tofree = cp = strdup(spec))) {
+		warn(NULL);
+		return 0;
+	}
+
+	while (NULL != (tok = strsep(&cp, ","))) {
+		if ('\0' == tok[0])
+			continue;
+		for (i = 0; i < TIER__MAX; i++)
+			if (0 == strcmp(tok, tierdefs[i].name))
+				break;
+		if (TIER__MAX == i) {
+			warnx("-H: %s: unknown interval", tok);
+			goto out;
+		}
+		tiers[i].archive = 1;
+	}
+
+	rc = 1;
+out:
+	free(tofree);
+	return rc;
+}
+
+/*
+ * Size the chunks of archived tiers, once their retention is known.
+ * Chunks are never larger than the retention, so the records not yet
+ * packed are always still in the record table if we're killed, and
+ * tiers_load() can recover them.
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+tiers_chunk_init(struct tier *tiers)
+{
+	size_t	 i;
+
+	for (i = 0; i < TIER__MAX; i++) {
+		if ( ! tiers[i].archive)
+			continue;
+		tiers[i].chunkmax = tiers[i].allowed < CHUNK_RECORDS ?
+			tiers[i].allowed : CHUNK_RECORDS;
+		tiers[i].chunk = calloc
+			(tiers[i].chunkmax, sizeof(struct record));
+		if (NULL == tiers[i].chunk) {
+			warn(NULL);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*
+ * Add the completed record "r" to the tier's chunk, packing and writing
+ * the chunk when it's full.
+ * Records already packed (when recovering in tiers_load()) are skipped.
+ * Return zero on failure, non-zero on success.
+ */
+static int
+tier_archive(struct ort *db, struct tier *t, const struct record *r)
+{
+	struct record	*c;
+	const void	*buf;
+	size_t		 sz;
+	int64_t		 id;
+
+	if ( ! t->archive || r->ctime <= t->chunklast)
+		return 1;
+
+	c = &t->chunk[t->chunksz++];
+	*c = *r;
+	c->summary = c->cores = c->metrics = NULL;
+	c->summary_sz = c->cores_sz = c->metrics_sz = 0;
+	if (t->chunksz < t->chunkmax)
+		return 1;
+
+	if (NULL == (buf = chunk_encode(t->chunk, t->chunksz, &sz))) {
+		warn(NULL);
+		return 0;
+	}
+	id = db_chunk_insert(db, t->ival, t->chunk[0].ctime,
+		c->ctime, t->chunksz, sz, buf);
+	free((void *)buf);
+	if (-1 == id)
+		return 0;
+	t->chunklast = c->ctime;
+	t->chunksz = 0;
+	return 1;
+}
+
+/*
+ * Copy the devices "ds" into the ring file rows "v".
+ */
+static void
+ringdev_fill(struct ringdev *v, const struct devset *ds)
+{
+	size_t	 i;
+
+	for (i = 0; i < ds->sz; i++) {
+		strlcpy(v[i].name, ds->v[i].name, sizeof(v[i].name));
+		v[i].rx = ds->v[i].rx;
+		v[i].tx = ds->v[i].tx;
+	}
+}
+
+/*
+ * Add the "sz" ring file rows "v" to the devices "ds".
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+ringdev_read(struct devset *ds, const struct ringdev *v, size_t sz)
+{
+	struct sysdev	 dev;
+	size_t		 i;
+
+	memset(&dev, 0, sizeof(struct sysdev));
+	for (i = 0; i < sz; i++) {
+		strlcpy(dev.name, v[i].name, sizeof(dev.name));
+		dev.rx = v[i].rx;
+		dev.tx = v[i].tx;
+		if ( ! devset_add(ds, &dev, 1))
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * Make the stored record "r" the head of "t", decoding its detail and,
+ * if "d" is not NULL, its per-device rows from the ring file.
+ * Return zero on failure, non-zero on success.
+ */
+static int
+tier_head(struct tier *t, const struct record *r, 
+	const struct ringdevs *d)
+{
+
+	t->head = *r;
+	t->head.summary = NULL;
+	t->head.summary_sz = 0;
+	t->head.cores = NULL;
+	t->head.cores_sz = 0;
+	t->head.metrics = NULL;
+	t->head.metrics_sz = 0;
+
+	detail_clear(&t->det);
+	if ( ! r->has_summary || ! summary_decode
+	    (&t->det.sum, r->summary, r->summary_sz))
+		summary_init(&t->det.sum);
+	if (r->has_cores && ! coreset_decode(&t->det.cores,
+	    r->cores, r->cores_sz, r->entries))
+		return 0;
+	if (r->has_metrics && ! metricset_decode
+	    (&t->det.metrics, r->metrics, r->metrics_sz))
+		return 0;
+	return NULL == d ||
+	    (ringdev_read(&t->det.ifs, d->ifs, d->ifsz) &&
+	     ringdev_read(&t->det.discs, d->discs, d->discsz));
+}
+
+/*
+ * Set the detail of the head of tier "i" from that recomputed by
+ * rollup() with the "rsz" records "rs", the device rows summed from
+ * those of the records it's made up of.
+ * These are the head of the finer tier "i - 1", whose detail must be
+ * set, and its older records, from the database or the ring file
+ * (with device rows "ringdevs" of its "ringsz" records).
+ * Return zero on failure, non-zero on success.
+ */
+static int
+tier_rollup(struct ort *db, struct tier *tiers, size_t i,
+	const struct record *const *rs, size_t rsz, 
+	const struct ringdevs *ringdevs, size_t ringsz)
+{
+	struct tier	*t = &tiers[i];
+	const struct tier *f = &tiers[i - 1];
+	struct record	 r = t->head;
+	struct detail	 tmp;
+	size_t		 j, k;
+	int		 rc;
+
+	rc = tier_head(t, &r, NULL);
+	free(r.summary);
+	free(r.cores);
+	free(r.metrics);
+	if ( ! rc)
+		return 0;
+
+	if (f->head.ctime >= t->head.ctime &&
+	    ( ! devset_add(&t->det.ifs, f->det.ifs.v, f->det.ifs.sz) ||
+	      ! devset_add(&t->det.discs, f->det.discs.v, f->det.discs.sz)))
+		return 0;
+
+	memset(&tmp, 0, sizeof(struct detail));
+	for (j = 0; rc && j < rsz; j++) {
+		if ( ! rollup_part(&t->head, &f->head, rs[j]))
+			continue;
+		if (rs[j]->id < 0 && 
+		    (k = -(rs[j]->id + 1)) < ringsz)
+			rc = ringdev_read(&t->det.ifs, 
+				ringdevs[k].ifs, ringdevs[k].ifsz) &&
+			    ringdev_read(&t->det.discs, 
+				ringdevs[k].discs, ringdevs[k].discsz);
+		else
+			rc = devices_read(db, rs[j]->id, &tmp) &&
+			    devset_add(&t->det.ifs, 
+				tmp.ifs.v, tmp.ifs.sz) &&
+			    devset_add(&t->det.discs, 
+				tmp.discs.v, tmp.discs.sz);
+	}
+	detail_free(&tmp);
+	return rc;
+}
+
+/*
+ * Load all tiers from the database records, or for those in the ring
+ * file, from its "ringsz" records "ring" with device rows "ringdevs".
+ * This is the only time we read the record table.
+ * If a tier has more records than its retention allows (it has been
+ * reduced since the last run), the oldest are removed.
+ * If "recompute", the newest records weren't written in rollup mode,
+ * so recompute them from the finer ones.
+ * Return zero on failure, non-zero on success.
+ */
+static int
+tiers_load(struct ort *db, struct tier *tiers, 
+	const struct record *ring, const struct ringdevs *ringdevs,
+	size_t ringsz, int recompute)
+{
+	struct record_q	*rq;
+	struct chunk_q	*cq;
+	const struct record *r;
+	const struct record **rs = NULL;
+	struct record	*heads[ROLLUP_IVALS];
+	const struct chunk *c;
+	struct tier	*t;
+	size_t		 i, j, rsz = 0, first;
+	int		 rc = 0;
+
+	if (NULL == db)
+		return 1;
+
+	for (i = 0; i < TIER__MAX; i++) {
+		if ( ! tiers[i].archive)
+			continue;
+		if (NULL == (cq = db_chunk_list_last(db, tiers[i].ival)))
+			return 0;
+		if (NULL != (c = TAILQ_FIRST(cq)))
+			tiers[i].chunklast = c->etime;
+		db_chunk_freeq(cq);
+	}
+
+	if (NULL == (rq = db_record_list_lister(db)))
+		return 0;
+
+	/*
+	 * The lister is newest-first, so walk it backward.
+	 * Each record but the newest is complete, so pack those not
+	 * yet packed.
+	 */
+
+	TAILQ_FOREACH_REVERSE(r, rq, record_q, _entries) {
+		for (i = 0; i < TIER__MAX; i++)
+			if (tiers[i].ival == r->interval)
+				break;
+		if (TIER__MAX == i || NULL != tiers[i].ring)
+			continue;
+		if (tiers[i].idsz && 
+		    ! tier_archive(db, &tiers[i], &tiers[i].head))
+			goto out;
+		if ( ! tier_push(&tiers[i], r->id))
+			goto out;
+		if ( ! tier_head(&tiers[i], r, NULL))
+			goto out;
+	}
+
+	/* Likewise for those from the previous ring, oldest first. */
+
+	for (j = 0; j < ringsz; j++) {
+		for (i = 0; i < TIER__MAX; i++)
+			if (tiers[i].ival == ring[j].interval)
+				break;
+		if (TIER__MAX == i || NULL == tiers[i].ring)
+			continue;
+		if (tiers[i].idsz && 
+		    ! tier_archive(db, &tiers[i], &tiers[i].head))
+			goto out;
+		ring_push(tiers[i].ring, &ring[j], &ringdevs[j]);
+		tiers[i].idsz = 1;
+		if ( ! tier_head(&tiers[i], &ring[j], &ringdevs[j]))
+			goto out;
+	}
+
+	for (i = 0; i < TIER__MAX; i++)
+		if (tiers[i].idsz && NULL == tiers[i].ring &&
+		    ! devices_read(db, tiers[i].head.id, &tiers[i].det))
+			goto out;
+
+	/* The first tiers are in interval order, as rollup() wants. */
+
+	if (recompute) {
+		TAILQ_FOREACH(r, rq, _entries)
+			rsz++;
+		rs = reallocarray(NULL, 
+			rsz + ringsz + 1, sizeof(struct record *));
+		if (NULL == rs) {
+			warn(NULL);
+			goto out;
+		}
+		rsz = 0;
+		TAILQ_FOREACH(r, rq, _entries) {
+			for (i = 0; i < TIER__MAX; i++)
+				if (tiers[i].ival == r->interval)
+					break;
+			if (TIER__MAX != i && NULL == tiers[i].ring)
+				rs[rsz++] = r;
+		}
+		for (j = 0; j < ringsz; j++)
+			rs[rsz++] = &ring[j];
+		for (i = 0; i < ROLLUP_IVALS; i++)
+			heads[i] = tiers[i].idsz ? &tiers[i].head : NULL;
+		for (first = 1; first < ROLLUP_IVALS &&
+		     NULL != tiers[first].ring; first++)
+			continue;
+
+		/*
+		 * Heads don't keep their blobs, so the one they're
+		 * recomputed from is merged from its record as read.
+		 */
+
+		for (j = 0; j < rsz && first < ROLLUP_IVALS; j++)
+			if (NULL != heads[first - 1] &&
+			    rs[j]->id == heads[first - 1]->id) {
+				heads[first - 1] = (struct record *)rs[j];
+				break;
+			}
+		rollup(heads, first, rs, rsz);
+		for (i = first; i < ROLLUP_IVALS; i++) {
+			if (NULL == heads[i] || NULL == heads[i - 1])
+				continue;
+			if ( ! tier_rollup(db, tiers, i, 
+			    rs, rsz, ringdevs, ringsz))
+				goto out;
+			tiers[i].dirty = 1;
+		}
+	}
+
+	db_trans_open(db, 1, 0);
+	for (i = 0; i < TIER__MAX; i++) {
+		t = &tiers[i];
+		while (SIZE_MAX != t->allowed && 
+		       t->idsz > t->allowed + 1) {
+			db_record_delete_id(db, t->ids[t->idstart]);
+			t->idstart = (t->idstart + 1) % t->idmax;
+			t->idsz--;
+		}
+	}
+	db_trans_commit(db, 1);
+
+	rc = 1;
+out:
+	free(rs);
+	db_record_freeq(rq);
+	return rc;
+}
+
+static void
+tiers_free(struct tier *tiers)
+{
+	size_t	 i;
+
+	for (i = 0; i < TIER__MAX; i++) {
+		free(tiers[i].ids);
+		free(tiers[i].chunk);
+		detail_free(&tiers[i].det);
+	}
+}
+
+/*
+ * Write the tier's newest record if it has unwritten samples.
+ */
+static void
+tier_flush(struct ort *db, struct tier *t)
+{
+
+	if ( ! t->dirty)
+		return;
+	record_update_current(db, &t->head, &t->det, t->head.id);
+	t->dirty = 0;
+}
+
+/*
+ * Write the head of "t" with its detail to the tier's ring file, as a
+ * new record if "push", else replacing its newest.
+ * If the detail can't be encoded, the record is written without it.
+ */
+static void
+tier_ring(struct tier *t, int push)
+{
+	struct record	 r = t->head;
+	struct ringdevs	 d, *dp = NULL;
+	struct ringdev	*v;
+	const void	*buf, *cbuf, *mbuf;
+	size_t		 sz = 0, csz, msz;
+
+	if (NULL == (buf = summary_encode(&t->det.sum, &sz)))
+		warn(NULL);
+	cbuf = coreset_encode(&t->det.cores, r.entries, &csz);
+	mbuf = metricset_encode(&t->det.metrics, &msz);
+	r.summary = (void *)buf;
+	r.summary_sz = sz;
+	r.has_summary = NULL != buf;
+	r.cores = (void *)cbuf;
+	r.cores_sz = csz;
+	r.has_cores = NULL != cbuf;
+	r.metrics = (void *)mbuf;
+	r.metrics_sz = msz;
+	r.has_metrics = NULL != mbuf;
+
+	v = reallocarray(NULL, t->det.ifs.sz + 
+		t->det.discs.sz + 1, sizeof(struct ringdev));
+	if (NULL != v) {
+		ringdev_fill(v, &t->det.ifs);
+		ringdev_fill(v + t->det.ifs.sz, &t->det.discs);
+		d.ifs = v;
+		d.ifsz = t->det.ifs.sz;
+		d.discs = v + t->det.ifs.sz;
+		d.discsz = t->det.discs.sz;
+		dp = &d;
+	} else
+		warn(NULL);
+
+	if (push)
+		ring_push(t->ring, &r, dp);
+	else
+		ring_head(t->ring, &r, dp);
+
+	free(v);
+	free((void *)buf);
+	free((void *)cbuf);
+	free((void *)mbuf);
+}
+
+/*
+ * Whether the tier's newest record covers "now".
+ */
+static int
+tier_current(const struct tier *t, time_t now)
+{
+
+	return ! t->seal && t->idsz > 0 && t->span > 0 && 
+		t->head.ctime + t->span > now;
+}
+
+/*
+ * Whether adding a sample at "now" to the tier, then flushing it if
+ * "flush" is set, writes to the database.
+ */
+static int
+tier_writes(const struct tier *t, time_t now, int flush)
+{
+
+	if (NULL != t->ring)
+		return t->archive && ! tier_current(t, now);
+	return flush || ! tier_current(t, now);
+}
+
+/*
+ * Add the sample "r" with detail "d" at time "now" into the tier.
+ * If the newest record still covers "now", accumulate into it in
+ * memory: it's written only when it's superseded or we checkpoint.
+ * Otherwise, start a new record, either recycling the oldest (the
+ * tail of the circular queue) or inserting if we're under quota.
+ * Tiers in the ring file are written there on every sample and
+ * recycle their own oldest.
+ * Return zero on failure, non-zero on success.
+ */
+static int
+tier_update(struct ort *db, struct tier *t, time_t now, 
+	const struct record *r, const struct detail *d)
+{
+	int64_t	 id;
+
+	if (tier_current(t, now)) {
+		/* Update the current entry. */
+		record_add(&t->head, r);
+		if ( ! detail_add(&t->det, d))
+			return 0;
+		if (NULL != t->ring)
+			tier_ring(t, 0);
+		else
+			t->dirty = 1;
+		return 1;
+	} 
+
+	tier_flush(db, t);
+	if (t->idsz > 0 && ! tier_archive(db, t, &t->head))
+		return 0;
+	
+	t->seal = 0;
+	if (NULL != t->ring) {
+		/* New entry in the ring file. */
+		id = 0;
+		t->idsz = 1;
+	} else if (t->idsz > t->allowed) {
+		/* New entry: shift end of circular queue. */
+		id = t->ids[t->idstart];
+		record_update_tail(db, now, r, d, id);
+		t->idstart = (t->idstart + 1) % t->idmax;
+		t->ids[(t->idstart + t->idsz - 1) % t->idmax] = id;
+	} else {
+		/* New entry. */
+		id = record_insert(db, now, t->ival, r, d);
+		if (-1 == id || ! tier_push(t, id))
+			return 0;
+	}
+
+	t->head = *r;
+	detail_clear(&t->det);
+	if ( ! detail_add(&t->det, d))
+		return 0;
+	t->head.ctime = now;
+	t->head.interval = t->ival;
+	t->head.id = id;
+	if (NULL != t->ring)
+		tier_ring(t, 1);
+	return 1;
+}
+
+/*
+ * Write all pending accumulations and the burst samples pending in
+ * "b".
+ */
+static void
+tiers_flush(struct ort *db, struct tier *tiers, struct burst *b)
+{
+	size_t	 i;
+
+	db_trans_open(db, 1, 0);
+	for (i = 0; i < b->pendsz; i++)
+		tier_update(db, &tiers[TIER_SEC], 
+			b->pend[i].t, &b->pend[i].rec, &b->pend[i].det);
+	b->pendsz = 0;
+	for (i = 0; i < TIER__MAX; i++)
+		tier_flush(db, &tiers[i]);
+	db_trans_commit(db, 1);
+}
+
+/*
+ * Open a side connection to "dbfile" used to switch the database into
+ * WAL mode and to schedule its checkpoints.
+ * This must be called before dropping privileges, as the side
+ * connection opens the -wal and -shm files here and keeps them open.
+ * Return NULL on failure.
+ */
+static sqlite3 *
+wal_open(const char *dbfile)
+{
+	sqlite3		*db;
+	sqlite3_stmt	*stmt = NULL;
+	const char	*mode;
+
+	if (SQLITE_OK != sqlite3_open_v2(dbfile, 
+	    &db, SQLITE_OPEN_READWRITE, NULL)) {
+		warnx("%s: %s", dbfile, NULL == db ? 
+			"out of memory" : sqlite3_errmsg(db));
+		sqlite3_close(db);
+		return NULL;
+	}
+
+	/* Wait for any readers or upgrades instead of failing. */
+
+	sqlite3_busy_timeout(db, 5000);
+
+	if (SQLITE_OK != sqlite3_prepare_v2(db, 
+	    "PRAGMA journal_mode=WAL", -1, &stmt, NULL) ||
+	    SQLITE_ROW != sqlite3_step(stmt)) {
+		warnx("%s: journal_mode: %s", 
+			dbfile, sqlite3_errmsg(db));
+		goto err;
+	}
+
+	mode = (const char *)sqlite3_column_text(stmt, 0);
+	if (NULL == mode || 0 != strcmp(mode, "wal")) {
+		warnx("%s: journal_mode: could not set WAL", dbfile);
+		goto err;
+	}
+
+	sqlite3_finalize(stmt);
+	stmt = NULL;
+
+	if (SQLITE_OK != sqlite3_wal_checkpoint_v2(db, 
+	    NULL, SQLITE_CHECKPOINT_PASSIVE, NULL, NULL)) {
+		warnx("%s: checkpoint: %s", dbfile, sqlite3_errmsg(db));
+		goto err;
+	}
+
+	return db;
+err:
+	sqlite3_finalize(stmt);
+	sqlite3_close(db);
+	return NULL;
+}
+
+/*
+ * Copy the write-ahead log back into the database.
+ * PASSIVE checkpoints never wait on readers or the writer; TRUNCATE,
+ * used on exit, waits and leaves an empty log.
+ * Failure is not fatal: the log is simply checkpointed later.
+ */
+static void
+wal_checkpoint(sqlite3 *db, int mode)
+{
+	int	 rc, logsz, ckptsz;
+
+	rc = sqlite3_wal_checkpoint_v2(db, NULL, mode, &logsz, &ckptsz);
+	if (SQLITE_OK != rc && SQLITE_BUSY != rc)
+		warnx("checkpoint: %s", sqlite3_errmsg(db));
+}
+
+/*
+ * Wake-ups on absolute deadlines, so that the time taken to sample and
+ * write doesn't accumulate as drift.
+ * Regular wake-ups are every "period"; while bursting, the schedule
+ * steps by the second in between them.
+ * On Linux, this uses a timerfd(2); elsewhere, the timeout to each
+ * deadline is computed for ppoll(2).
+ */
+struct	sched {
+	time_t		 period; /* seconds between regular wake-ups */
+	time_t		 step; /* seconds between wake-ups */
+	time_t		 left; /* wake-ups until the regular one */
+	struct timespec	 next; /* next deadline (monotonic) */
+	uint64_t	 missed; /* deadlines skipped */
+	int		 fd; /* timerfd or -1 */
+};
+
+/*
+ * Start the schedule with the first deadline one period from now.
+ * Return zero on failure, non-zero on success.
+ */
+static int
+sched_init(struct sched *sc, time_t period)
+{
+#ifdef __linux__
+	struct itimerspec its;
+#endif
+
+	sc->period = sc->step = period;
+	sc->left = 1;
+	sc->missed = 0;
+
+	if (-1 == clock_gettime(CLOCK_MONOTONIC, &sc->next)) {
+		warn("clock_gettime");
+		return 0;
+	}
+	sc->next.tv_sec += period;
+
+#ifdef __linux__
+	sc->fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+	if (-1 == sc->fd) {
+		warn("timerfd_create");
+		return 0;
+	}
+	its.it_value = sc->next;
+	its.it_interval.tv_sec = period;
+	its.it_interval.tv_nsec = 0;
+	if (-1 == timerfd_settime(sc->fd, TFD_TIMER_ABSTIME, &its, NULL)) {
+		warn("timerfd_settime");
+		return 0;
+	}
+#endif
+	return 1;
+}
 
-#include <assert.h>
-#if HAVE_ERR
-# include <err.h>
+static void
+sched_free(struct sched *sc)
+{
+
+	if (-1 != sc->fd)
+		close(sc->fd);
+}
+
+/*
+ * Change the step between wake-ups, which must divide the period.
+ * This must be called just after a regular wake-up so that the steps
+ * line up with the regular deadlines.
+ * Return zero on failure, non-zero on success.
+ */
+static int
+sched_step(struct sched *sc, time_t step)
+{
+#ifdef __linux__
+	struct itimerspec its;
 #endif
-#include <errno.h>
-#include <fcntl.h>
-#include <inttypes.h>
-#include <limits.h>
-#include <paths.h>
-#include <poll.h>
-#include <signal.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <time.h>
-#include <unistd.h>
 
-#include "slant-collectd.h"
-#include "extern.h"
-#include "db.h"
+	assert(0 == sc->period % step);
+	sc->next.tv_sec += step - sc->step;
+	sc->step = step;
+	sc->left = sc->period / step;
+
+#ifdef __linux__
+	its.it_value = sc->next;
+	its.it_interval.tv_sec = step;
+	its.it_interval.tv_nsec = 0;
+	if (-1 == timerfd_settime(sc->fd, TFD_TIMER_ABSTIME, &its, NULL)) {
+		warn("timerfd_settime");
+		return 0;
+	}
+#endif
+	return 1;
+}
 
-#ifndef _PATH_VAREMPTY
-# define _PATH_VAREMPTY "/var/empty"
+/*
+ * Account for "exp" elapsed deadlines, the last of which has just
+ * passed.
+ * Return 1 if a regular deadline passed, else 2.
+ */
+static int
+sched_tick(struct sched *sc, uint64_t exp)
+{
+	time_t	 n = sc->period / sc->step;
+
+	if (exp < (uint64_t)sc->left) {
+		sc->left -= exp;
+		return 2;
+	}
+	sc->left = n - (exp - sc->left) % n;
+	return 1;
+}
+
+/*
+ * Wait for the next deadline or a signal in "sset".
+ * Deadlines we've already missed are skipped, not run back-to-back.
+ * Return -1 on failure, 0 if interrupted, 1 at a regular deadline, 2
+ * at a burst step between regular deadlines.
+ */
+static int
+sched_wait(struct sched *sc, const sigset_t *sset)
+{
+#ifdef __linux__
+	struct pollfd	 pfd;
+	uint64_t	 exp;
+
+	pfd.fd = sc->fd;
+	pfd.events = POLLIN;
+	if (-1 == ppoll(&pfd, 1, NULL, sset)) {
+		if (EINTR == errno)
+			return 0;
+		warn("ppoll");
+		return -1;
+	}
+	if (-1 == read(sc->fd, &exp, sizeof(exp))) {
+		if (EAGAIN == errno || EINTR == errno)
+			return 0;
+		warn("read: timerfd");
+		return -1;
+	}
+	sc->next.tv_sec += exp * sc->step;
+	sc->missed += exp - 1;
+	return sched_tick(sc, exp);
+#else
+	struct timespec	 now, timeo;
+	uint64_t	 exp = 1;
+
+	if (-1 == clock_gettime(CLOCK_MONOTONIC, &now)) {
+		warn("clock_gettime");
+		return -1;
+	}
+
+	while (now.tv_sec > sc->next.tv_sec ||
+	       (now.tv_sec == sc->next.tv_sec && 
+	        now.tv_nsec >= sc->next.tv_nsec)) {
+		sc->next.tv_sec += sc->step;
+		exp++;
+	}
+
+	timeo.tv_sec = sc->next.tv_sec - now.tv_sec;
+	timeo.tv_nsec = sc->next.tv_nsec - now.tv_nsec;
+	if (timeo.tv_nsec < 0) {
+		timeo.tv_sec--;
+		timeo.tv_nsec += 1000000000L;
+	}
+
+	if (-1 == ppoll(NULL, 0, &timeo, sset)) {
+		if (EINTR == errno)
+			return 0;
+		warn("ppoll");
+		return -1;
+	}
+	sc->next.tv_sec += sc->step;
+	sc->missed += exp - 1;
+	return sched_tick(sc, exp);
 #endif
+}
 
-static	sig_atomic_t	doexit = 0;
+/*
+ * Add "secs", the duration of one run of a stage, to its histogram.
+ */
+static void
+stage_add(struct stagehist *h, double secs)
+{
+	double	 us, lim;
+	size_t	 k;
+
+	if (secs < 0.0)
+		secs = 0.0;
+	us = secs * 1000000.0;
+	for (k = 0, lim = 1.0; k < STAGE_BUCKETS - 1 && us >= lim; k++)
+		lim *= 2.0;
+	h->bucket[k]++;
+	h->count++;
+	h->sum += secs;
+	if (secs > h->max)
+		h->max = secs;
+}
 
+/*
+ * Start timing a stage at "start".
+ */
 static void
-sig(int sig)
+stage_start(struct timespec *start)
 {
 
-	doexit = 1;
+	if (-1 == clock_gettime(CLOCK_MONOTONIC, start)) {
+		warn("clock_gettime");
+		start->tv_sec = -1;
+	}
 }
 
+/*
+ * Add the time since "start" (see stage_start()) to "h".
+ */
 static void
-update_interval(struct ort *db, time_t span, 
-	size_t have, size_t allowed,
-	const struct record *first, const struct record *last, 
-	enum interval ival, time_t now, const struct record *r)
+stage_end(struct stagehist *h, const struct timespec *start)
 {
+	struct timespec	 now;
 
-	assert(allowed > 0);
+	if (start->tv_sec < 0)
+		return;
+	if (-1 == clock_gettime(CLOCK_MONOTONIC, &now)) {
+		warn("clock_gettime");
+		return;
+	}
+	stage_add(h, (now.tv_sec - start->tv_sec) +
+		(now.tv_nsec - start->tv_nsec) / 1000000000.0);
+}
 
-	if (NULL != first && first->ctime + span > now) {
-		/* Update the current entry. */
-		assert(NULL != first);
-		assert(NULL != last);
-		db_record_update_current(db, 
-			first->entries + 1, 
-			first->cpu + r->cpu, 
-			first->mem + r->mem, 
-			first->nettx + r->nettx, 
-			first->netrx + r->netrx, 
-			first->discread + r->discread, 
-			first->discwrite + r->discwrite, 
-			first->nprocs + r->nprocs,
-			first->rprocs + r->rprocs,
-			first->nfiles + r->nfiles,
-			first->id);
-	} else if (have > allowed) {
-		/* New entry: shift end of circular queue. */
-		assert(NULL != first);
-		assert(NULL != last);
-		db_record_update_tail(db, now, 1, 
-			r->cpu, r->mem, r->nettx, r->netrx,
-			r->discread, r->discwrite, r->nprocs,
-			r->rprocs, r->nfiles, last->id);
-	} else {
-		/* New entry. */
-		db_record_insert(db, now, 1, 
-			r->cpu, r->mem, r->nettx, r->netrx,
-			r->discread, r->discwrite, r->nprocs, 
-			r->rprocs, r->nfiles, ival);
+/*
+ * Estimate the "q" quantile (from zero to one) of a stage's durations
+ * in seconds as the upper bound of its bucket, if not the maximum.
+ */
+static double
+stage_quantile(const struct stagehist *h, double q)
+{
+	uint64_t	 rank, seen = 0;
+	size_t		 k;
+	double		 lim;
+
+	if (0 == h->count)
+		return 0.0;
+	rank = q * h->count;
+	if (rank < q * h->count || 0 == rank)
+		rank++;
+	for (k = 0, lim = 1.0; k < STAGE_BUCKETS - 1; k++, lim *= 2.0)
+		if ((seen += h->bucket[k]) >= rank)
+			break;
+	lim /= 1000000.0;
+	return lim < h->max ? lim : h->max;
+}
+
+/*
+ * Make sure each stage has its row in the database.
+ * Return zero on failure, non-zero on success.
+ */
+static int
+stages_init(struct ort *db, struct stages *st)
+{
+	struct stage	*s;
+	size_t		 i;
+	int		 rc = 1;
+
+	st->since = time(NULL);
+	if (NULL == db)
+		return 1;
+
+	db_trans_open(db, 4, 0);
+	for (i = 0; i < STAGE__MAX; i++) {
+		if (NULL != (s = db_stage_get_name(db, stages[i]))) {
+			db_stage_free(s);
+			continue;
+		}
+		if (-1 == db_stage_insert(db, stages[i], 
+		    0, 0.0, 0, 0, 0, st->since)) {
+			warnx("%s: cannot register stage", stages[i]);
+			rc = 0;
+			break;
+		}
+	}
+	db_trans_commit(db, 4);
+	return rc;
+}
+
+/*
+ * Write the durations of each stage so far.
+ * This must be within a transaction.
+ */
+static void
+stages_write(struct ort *db, const struct stages *st)
+{
+	const struct stagehist *h;
+	size_t		 i;
+
+	for (i = 0; i < STAGE__MAX; i++) {
+		h = &st->hist[i];
+		db_stage_update_name(db, h->count, 
+			0 == h->count ? 0.0 : 
+			h->sum * 1000000.0 / h->count,
+			stage_quantile(h, 0.5) * 1000000.0,
+			stage_quantile(h, 0.99) * 1000000.0,
+			h->max * 1000000.0, st->since, stages[i]);
+	}
+}
+
+/*
+ * Print the median, 99th percentile, and longest duration of each
+ * stage in microseconds, and the number of deadlines missed.
+ */
+static void
+stages_print(const struct stages *st, uint64_t missed)
+{
+	const struct stagehist *h;
+	size_t		 i;
+
+	printf("# Stages (us):");
+	for (i = 0; i < STAGE__MAX; i++) {
+		h = &st->hist[i];
+		printf(" %s %.0f/%.0f/%.0f", stages[i],
+			stage_quantile(h, 0.5) * 1000000.0,
+			stage_quantile(h, 0.99) * 1000000.0,
+			h->max * 1000000.0);
 	}
+	printf(" missed %" PRIu64 "\n", missed);
 }
 
 static void
@@ -110,29 +1976,93 @@ printinit(const struct sysinfo *p)
 static void
 print(const struct sysinfo *p)
 {
+	const struct sysmetric *m;
+	size_t	 i, sz;
 
 	printf("%9.1f%% %9.1f%% "
 		"%10" PRId64 " %10" PRId64 " "
+		"%8" PRId64 " %8" PRId64 " "
 		"%10" PRId64 " %10" PRId64 " "
-		"%9.1f%% %9.1f%% %9.1f%%\n",
+		"%8" PRId64 " %7.1f %5.1f%% "
+		"%9.1f%% %9.1f%% %9.1f%%",
 		sysinfo_get_cpu_avg(p),
 		sysinfo_get_mem_avg(p),
 		sysinfo_get_nettx_avg(p),
 		sysinfo_get_netrx_avg(p),
+		sysinfo_get_nettxpkt_avg(p),
+		sysinfo_get_netrxpkt_avg(p),
 		sysinfo_get_discread_avg(p),
 		sysinfo_get_discwrite_avg(p),
+		sysinfo_get_disciops_avg(p),
+		sysinfo_get_discawait_avg(p),
+		sysinfo_get_discbusy_avg(p),
 		sysinfo_get_nprocs(p),
 		sysinfo_get_rprocs(p),
 		sysinfo_get_nfiles(p));
+	sz = sysinfo_get_metrics(p, &m);
+	for (i = 0; i < sz; i++)
+		printf(" %s %.1f", m[i].name, m[i].value);
+	for (i = 0; i < SYSRC__MAX; i++)
+		if (sysinfo_get_stale(p, i))
+			printf(" (stale %s)", sysrcs[i]);
+	putchar('\n');
+}
+
+/*
+ * Parse a sampling spec "name=divisor[,name=divisor...]", with names as
+ * in "sysrcs", into the sampling divisors of each source.
+ * Return zero on failure, non-zero on success.
+ */
+static int
+sources_parse(struct syscfg *cfg, const char *spec)
+{
+	char		*cp, *tofree, *tok, *val;
+	const char	*er;
+	size_t		 i;
+	int		 rc = 0;
+
+	if (NULL == (tofree = cp = strdup(spec))) {
+		warn(NULL);
+		return 0;
+	}
+
+	while (NULL != (tok = strsep(&cp, ","))) {
+		if ('\0' == tok[0])
+			continue;
+		if (NULL == (val = strchr(tok, '='))) {
+			warnx("-s: %s: expected name=divisor", tok);
+			goto out;
+		}
+		*val++ = '\0';
+		for (i = 0; i < SYSRC__MAX; i++)
+			if (0 == strcmp(tok, sysrcs[i]))
+				break;
+		if (SYSRC__MAX == i) {
+			warnx("-s: %s: unknown source", tok);
+			goto out;
+		}
+		cfg->divs[i] = strtonum(val, 1, 3600, &er);
+		if (NULL != er) {
+			warnx("-s: %s: %s", tok, er);
+			goto out;
+		}
+	}
+
+	rc = 1;
+out:
+	free(tofree);
+	return rc;
 }
 
 /*
  * Initialise the database by updating our runtime information in the
  * "system" table.
+ * Sets "prevrollup" to whether the last run was in rollup mode.
  * Return zero on failure, non-zero on success.
  */
 static int
-init(struct ort *db, const struct sysinfo *p)
+init(struct ort *db, const struct sysinfo *p, time_t period,
+	int rollup, int ring, int *prevrollup)
 {
 	struct system	*s;
 	struct utsname	 uts;
@@ -150,13 +2080,18 @@ init(struct ort *db, const struct sysinfo *p)
 
 	db_trans_open(db, 2, 0);
 
+	*prevrollup = 0;
 	if (NULL != (s = db_system_get_id(db, 1))) {
+		*prevrollup = 0 != s->rollup;
 		db_system_update_all(db, 
 			sysinfo_get_boottime(p), /* boot */
 			&mach,	/* machine */
 			&ver,	/* osversion */
 			&rel,	/* osrelease */
 			&sys,	/* sysname */
+			period,	/* period */
+			rollup,	/* rollup */
+			ring,	/* ring */
 			1	/* id */ );
 		db_system_free(s);
 	} else
@@ -166,6 +2101,9 @@ init(struct ort *db, const struct sysinfo *p)
 			&ver,	/* osversion */
 			&rel,	/* osrelease */
 			&sys,	/* sysname */
+			period,	/* period */
+			rollup,	/* rollup */
+			ring,	/* ring */
 			1	/* id */ );
 
 	db_trans_commit(db, 2);
@@ -173,132 +2111,272 @@ init(struct ort *db, const struct sysinfo *p)
 }
 
 /*
- * Update the database "db" given the current record "p" and all
- * existing database records "rq".
+ * Register the backend's metrics in "db", looking up the identifier of
+ * each by its name and adding those not yet known.
+ * Without a database, identifiers follow the backend's order.
+ * Sets "ids" (parallel to sysinfo_get_metrics()) to be freed by the
+ * caller.
+ * Return zero on failure, non-zero on success.
  */
-static void
-update(struct ort *db, const struct sysinfo *p, 
-	const struct record_q *rq)
+static int
+metrics_init(struct ort *db, const struct sysinfo *p, int64_t **ids)
 {
-	size_t	 	 bymin = 0, byhour = 0, byqmin = 0,
-			 byday = 0, byweek = 0, byyear = 0;
-	time_t		 t = time(NULL);
-	struct record	 rr;
-	const struct record *r, 
-	      		*first_bymin = NULL, *last_bymin = NULL,
-			*first_byqmin = NULL, *last_byqmin = NULL,
-			*first_byhour = NULL, *last_byhour = NULL,
-			*first_byday = NULL, *last_byday = NULL,
-			*first_byweek = NULL, *last_byweek = NULL,
-			*first_byyear = NULL, *last_byyear = NULL;
-
-	memset(&rr, 0, sizeof(struct record));
-	rr.cpu = sysinfo_get_cpu_avg(p);
-	rr.mem = sysinfo_get_mem_avg(p);
-	rr.nettx = sysinfo_get_nettx_avg(p);
-	rr.netrx = sysinfo_get_netrx_avg(p);
-	rr.discread = sysinfo_get_discread_avg(p);
-	rr.discwrite = sysinfo_get_discwrite_avg(p);
-	rr.nprocs = sysinfo_get_nprocs(p);
-	rr.rprocs = sysinfo_get_rprocs(p);
-	rr.nfiles = sysinfo_get_nfiles(p);
+	const struct sysmetric *v;
+	struct metric	*m;
+	size_t		 i, sz;
+	int		 rc = 1;
+
+	if (0 == (sz = sysinfo_get_metrics(p, &v)))
+		return 1;
+	if (NULL == (*ids = calloc(sz, sizeof(int64_t)))) {
+		warn(NULL);
+		return 0;
+	}
 
-	/* 
-	 * First count what we have.
-	 * We need this when determining how many "spare" entries to
-	 * keep in any given interval, e.g., we keep 5 minutes of
-	 * quarter-minute interval data, but only really need the last
-	 * single minute for accumulation.
-	 */
+	if (NULL == db) {
+		for (i = 0; i < sz; i++)
+			(*ids)[i] = i + 1;
+		return 1;
+	}
 
-	TAILQ_FOREACH(r, rq, _entries)
-		switch (r->interval) {
-		case INTERVAL_byqmin:
-			if (NULL == first_byqmin)
-				first_byqmin = r;
-			last_byqmin = r;
-			byqmin++;
-			break;
-		case INTERVAL_bymin:
-			if (NULL == first_bymin)
-				first_bymin = r;
-			last_bymin = r;
-			bymin++;
-			break;
-		case INTERVAL_byhour:
-			if (NULL == first_byhour)
-				first_byhour = r;
-			last_byhour = r;
-			byhour++;
-			break;
-		case INTERVAL_byday:
-			if (NULL == first_byday)
-				first_byday = r;
-			last_byday = r;
-			byday++;
-			break;
-		case INTERVAL_byweek:
-			if (NULL == first_byweek)
-				first_byweek = r;
-			last_byweek = r;
-			byweek++;
-			break;
-		case INTERVAL_byyear:
-			if (NULL == first_byyear)
-				first_byyear = r;
-			last_byyear = r;
-			byyear++;
+	db_trans_open(db, 3, 0);
+	for (i = 0; i < sz; i++) {
+		if (NULL != (m = db_metric_get_name(db, v[i].name))) {
+			(*ids)[i] = m->id;
+			db_metric_free(m);
+		} else
+			(*ids)[i] = db_metric_insert(db, v[i].name);
+		if (-1 == (*ids)[i]) {
+			warnx("%s: cannot register metric", v[i].name);
+			rc = 0;
 			break;
 		}
+	}
+	db_trans_commit(db, 3);
+	return rc;
+}
 
-	db_trans_open(db, 1, 0);
-
-	/* 40 (10 minute) backlog of quarter-minute entries. */
-
-	if (byqmin > (4 * 10)) {
-		assert(NULL != last_byqmin);
-		assert(NULL != first_byqmin);
-		db_record_update_tail(db, t, 1, 
-			rr.cpu, rr.mem, rr.nettx, rr.netrx,
-			rr.discread, rr.discwrite, rr.nprocs,
-			rr.rprocs, rr.nfiles, last_byqmin->id);
-	} else
-		db_record_insert(db, t, 1,
-			rr.cpu, rr.mem, rr.nettx, rr.netrx,
-			rr.discread, rr.discwrite, rr.nprocs,
-			rr.rprocs, rr.nfiles, INTERVAL_byqmin);
+/*
+ * Fill in the single sample "rr" and its detail "d" from the current
+ * system state "p", with metric identifiers "ids" from metrics_init().
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+sample(const struct sysinfo *p, const int64_t *ids, 
+	struct record *rr, struct detail *d)
+{
+	const struct sysdev *v;
+	const struct sysmetric *m;
+	struct metricval mv;
+	size_t		 i, sz;
+
+	memset(rr, 0, sizeof(struct record));
+	rr->entries = 1;
+	rr->cpu = sysinfo_get_cpu_avg(p);
+	rr->mem = sysinfo_get_mem_avg(p);
+	rr->nettx = sysinfo_get_nettx_avg(p);
+	rr->netrx = sysinfo_get_netrx_avg(p);
+	rr->nettxpkt = sysinfo_get_nettxpkt_avg(p);
+	rr->netrxpkt = sysinfo_get_netrxpkt_avg(p);
+	rr->nettxerr = sysinfo_get_nettxerr_avg(p);
+	rr->netrxerr = sysinfo_get_netrxerr_avg(p);
+	rr->netcoll = sysinfo_get_netcoll_avg(p);
+	rr->discread = sysinfo_get_discread_avg(p);
+	rr->discwrite = sysinfo_get_discwrite_avg(p);
+	rr->disciops = sysinfo_get_disciops_avg(p);
+	rr->discawait = sysinfo_get_discawait_avg(p);
+	rr->discbusy = sysinfo_get_discbusy_avg(p);
+	rr->nprocs = sysinfo_get_nprocs(p);
+	rr->rprocs = sysinfo_get_rprocs(p);
+	rr->nfiles = sysinfo_get_nfiles(p);
+	rr->ctxt = sysinfo_get_ctxt_avg(p);
+	rr->intr = sysinfo_get_intr_avg(p);
+	rr->procsrun = sysinfo_get_procsrun(p);
+	rr->procsblk = sysinfo_get_procsblk(p);
+	rr->load1 = sysinfo_get_load1(p);
+	rr->load5 = sysinfo_get_load5(p);
+	rr->load15 = sysinfo_get_load15(p);
+	rr->psicpusome = sysinfo_get_psi_some(p, PSI_CPU);
+	rr->psicpufull = sysinfo_get_psi_full(p, PSI_CPU);
+	rr->psimemsome = sysinfo_get_psi_some(p, PSI_MEM);
+	rr->psimemfull = sysinfo_get_psi_full(p, PSI_MEM);
+	rr->psiiosome = sysinfo_get_psi_some(p, PSI_IO);
+	rr->psiiofull = sysinfo_get_psi_full(p, PSI_IO);
+
+	detail_clear(d);
+	record_summary(rr, &d->sum);
+	if ( ! coreset_sample(&d->cores, p))
+		return 0;
+	sz = sysinfo_get_ifs(p, &v);
+	if ( ! devset_add(&d->ifs, v, sz))
+		return 0;
+	sz = sysinfo_get_discs(p, &v);
+	if ( ! devset_add(&d->discs, v, sz))
+		return 0;
+	sz = sysinfo_get_metrics(p, &m);
+	for (i = 0; i < sz; i++) {
+		mv.id = ids[i];
+		mv.v = m[i].value;
+		if ( ! metricset_add(&d->metrics, &mv, 1))
+			return 0;
+	}
+	return 1;
+}
 
-	/* 300 (5 hours) backlog of by-minute entries. */
+/*
+ * Update the database "db" and our regular tiers given the sample
+ * "rr" with detail "d".
+ * Burst samples pending in "b" are written to the per-second tier
+ * in the same transaction.
+ * If "flush" is set, also write all pending accumulations.
+ * In "rollup" mode, a record starting starts a record in each finer
+ * tier, and pending accumulations are only written when complete, as
+ * readers recompute the newest records from the finer ones.
+ * Time the update and commit into "st", also writing it if "flush".
+ * Return zero on failure, non-zero on success.
+ */
+static int
+update(struct ort *db, const struct record *rr, 
+	const struct detail *d, struct tier *tiers, struct burst *b,
+	int flush, int rollup, struct stages *st)
+{
+	time_t		 t = time(NULL);
+	struct timespec	 start;
+	size_t		 i, j;
+	int		 rc = 1, trans = flush || b->pendsz > 0;
+
+	for (i = 1; rollup && i < TIER_SEC; i++)
+		if ( ! tier_current(&tiers[i], t))
+			for (j = 0; j < i; j++)
+				tiers[j].seal = 1;
+
+	/* Usually only the ring file is written: skip the database. */
+
+	for (i = 0; ! trans && i < TIER_SEC; i++)
+		trans = tier_writes(&tiers[i], t, flush);
+
+	stage_start(&start);
+	if (trans)
+		db_trans_open(db, 1, 0);
+	for (i = 0; rc && i < b->pendsz; i++)
+		rc = tier_update(db, &tiers[TIER_SEC], 
+			b->pend[i].t, &b->pend[i].rec, &b->pend[i].det);
+	b->pendsz = 0;
+	for (i = 0; rc && i < TIER_SEC; i++)
+		rc = tier_update(db, &tiers[i], t, rr, d);
+	for (i = rollup ? TIER_SEC : 0; rc && flush && i < TIER__MAX; i++)
+		tier_flush(db, &tiers[i]);
+	if (flush)
+		stages_write(db, st);
+	stage_end(&st->hist[STAGE_TIERS], &start);
+	if (trans) {
+		stage_start(&start);
+		db_trans_commit(db, 1);
+		stage_end(&st->hist[STAGE_COMMIT], &start);
+	}
+	return rc;
+}
 
-	update_interval(db, 60, bymin, 
-		60 * 5, first_bymin, last_bymin, 
-		INTERVAL_bymin, t, &rr);
+/*
+ * Queue the burst sample "rr" with detail "d" for the per-second
+ * tier, to be written with the next regular update.
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+burst_push(struct burst *b, const struct record *rr, 
+	const struct detail *d)
+{
+	struct pending	*p;
+	size_t		 max;
+
+	if (b->pendsz == b->pendmax) {
+		max = b->pendmax + 16;
+		p = reallocarray(b->pend, max, sizeof(struct pending));
+		if (NULL == p) {
+			warn(NULL);
+			return 0;
+		}
+		memset(&p[b->pendmax], 0, 
+			(max - b->pendmax) * sizeof(struct pending));
+		b->pend = p;
+		b->pendmax = max;
+	}
 
-	/* 96 (5 days) backlog of by-hour entries. */
+	p = &b->pend[b->pendsz];
+	p->t = time(NULL);
+	p->rec = *rr;
+	detail_clear(&p->det);
+	if ( ! detail_add(&p->det, d))
+		return 0;
+	b->pendsz++;
+	return 1;
+}
 
-	update_interval(db, 60 * 60, byhour, 
-		24 * 5, first_byhour, last_byhour, 
-		INTERVAL_byhour, t, &rr);
+/*
+ * Parse a burst spec "name=value[,name=value...]" with names "cpu"
+ * (percentage), "disc" (read and written bytes per second), and
+ * "window" (seconds).
+ * At least one threshold must be given.
+ * Return zero on failure, non-zero on success.
+ */
+static int
+burst_parse(struct burst *b, const char *spec)
+{
+	char		*cp, *tofree, *tok, *val;
+	const char	*er = NULL;
+	int		 rc = 0;
 
-	/* 28 (4 weeks) backlog of by-day entries. */
+	if (NULL == (tofree = cp = strdup(spec))) {
+		warn(NULL);
+		return 0;
+	}
 
-	update_interval(db, 60 * 60 * 24, byday, 
-		7 * 4, first_byday, last_byday, 
-		INTERVAL_byday, t, &rr);
+	b->window = 60;
 
-	/* 104 (two year) backlog of by-week entries. */
+	while (NULL != (tok = strsep(&cp, ","))) {
+		if ('\0' == tok[0])
+			continue;
+		if (NULL == (val = strchr(tok, '='))) {
+			warnx("-B: %s: expected name=value", tok);
+			goto out;
+		}
+		*val++ = '\0';
+		if (0 == strcmp(tok, "cpu"))
+			b->cpu = strtonum(val, 1, 100, &er);
+		else if (0 == strcmp(tok, "disc"))
+			b->disc = strtonum(val, 1, LLONG_MAX, &er);
+		else if (0 == strcmp(tok, "window"))
+			b->window = strtonum(val, 1, 3600, &er);
+		else {
+			warnx("-B: %s: unknown name", tok);
+			goto out;
+		}
+		if (NULL != er) {
+			warnx("-B: %s: %s", tok, er);
+			goto out;
+		}
+	}
 
-	update_interval(db, 60 * 60 * 24 * 7, byweek, 
-		52 * 2, first_byday, last_byweek, 
-		INTERVAL_byweek, t, &rr);
+	if (0 == b->cpu && 0 == b->disc) {
+		warnx("-B: expected cpu or disc threshold");
+		goto out;
+	}
 
-	/* Endless backlog of yearly entries. */
+	rc = 1;
+out:
+	free(tofree);
+	return rc;
+}
 
-	update_interval(db, 60 * 60 * 24 * 365, byyear, 
-		SIZE_MAX, first_byyear, last_byyear, 
-		INTERVAL_byyear, t, &rr);
+/*
+ * Whether the sample "rr" crosses a burst threshold.
+ */
+static int
+burst_hit(const struct burst *b, const struct record *rr)
+{
 
-	db_trans_commit(db, 1);
+	return (b->cpu > 0 && rr->cpu >= b->cpu) ||
+	       (b->disc > 0 && rr->discread + rr->discwrite >= b->disc);
 }
 
 static void
@@ -319,17 +2397,34 @@ int
 main(int argc, char *argv[])
 {
 	struct ort	*db = NULL;
-	struct record_q	*rq;
-	struct sysinfo	*info;
-	int		 c, rc = 0, noop = 0, verb = 0;
-	const char	*dbfile = "/var/www/data/slant.db";
+	struct sysinfo	*info = NULL;
+	struct tier	 tiers[TIER__MAX];
+	struct record	 rr;
+	struct detail	 det;
+	const struct detail *dp;
+	struct burst	 burst;
+	int		 c, rc = 0, noop = 0, verb = 0, flush, 
+			 usewal = 0, rollup = 0, prevrollup = 0;
+	sqlite3		*wal = NULL;
+	const char	*dbfile = "/var/www/data/slant.db", *er,
+	      		*retention = NULL, *sources = NULL,
+			*bursts = NULL, *archive = NULL;
+	time_t		 ckpt = 300, lastckpt, period = 15, step;
 	char		*d, *discs = NULL, *procs = NULL, *tofree;
 	struct syscfg	 cfg;
 	sigset_t	 sset;
-	struct timespec	 timeo;
-
-	timeo.tv_nsec = 0;
-	timeo.tv_sec = 15;
+	struct sched	 sc;
+	struct stages	 st;
+	struct timespec	 late;
+	int64_t		*mids = NULL;
+	const char	*ringfile = NULL;
+	struct ring	*ring = NULL;
+	struct record	*ringrecs = NULL;
+	struct ringdevs	*ringdevs = NULL;
+	size_t		 ringsz = 0, i;
+
+	sc.fd = -1;
+	memset(&st, 0, sizeof(struct stages));
 
 	/*
 	 * FIXME: relax this restriction.
@@ -344,24 +2439,62 @@ main(int argc, char *argv[])
 		errx(EXIT_FAILURE, "must be run as root");
 
 	memset(&cfg, 0, sizeof(struct syscfg));
+	memset(tiers, 0, sizeof(tiers));
+	memset(&burst, 0, sizeof(struct burst));
+	memset(&det, 0, sizeof(struct detail));
+	tiers_init(tiers);
 
-	while (-1 != (c = getopt(argc, argv, "d:nvf:p:")))
+	while (-1 != (c = getopt(argc, argv, "aB:c:d:H:nvf:i:p:R:r:s:Vw")))
 		switch (c) {
+		case 'a':
+			rollup = 1;
+			break;
+		case 'B':
+			bursts = optarg;
+			break;
+		case 'c':
+			ckpt = strtonum(optarg, 1, 86400, &er);
+			if (NULL != er)
+				errx(EXIT_FAILURE, "-c: %s", er);
+			break;
 		case 'd':
 			discs = optarg;
 			break;
 		case 'f':
 			dbfile = optarg;
 			break;
+		case 'H':
+			archive = optarg;
+			break;
+		case 'i':
+			period = strtonum(optarg, 1, 60, &er);
+			if (NULL != er)
+				errx(EXIT_FAILURE, "-i: %s", er);
+			break;
 		case 'n':
 			noop = 1;
 			break;
 		case 'p':
 			procs = optarg;
 			break;
+		case 'R':
+			ringfile = optarg;
+			break;
+		case 'r':
+			retention = optarg;
+			break;
+		case 's':
+			sources = optarg;
+			break;
 		case 'v':
 			verb = 1;
 			break;
+		case 'V':
+			cfg.validate = 1;
+			break;
+		case 'w':
+			usewal = 1;
+			break;
 		default:
 			goto usage;
 		}
@@ -369,6 +2502,43 @@ main(int argc, char *argv[])
 	argc -= optind;
 	argv += optind;
 
+	if (NULL != retention && ! tiers_retention(tiers, retention))
+		goto usage;
+	if (NULL != archive && ! tiers_archive(tiers, archive))
+		goto usage;
+	for (i = 0; NULL != ringfile && i < TIER__MAX; i++)
+		if (ring_has(tiers[i].ival) && SIZE_MAX == tiers[i].allowed)
+			errx(EXIT_FAILURE, "-R: %s must be bounded", 
+				tierdefs[i].name);
+
+	/* Each tier must keep enough to recompute the next's newest. */
+
+	for (i = 1; rollup && i < TIER_SEC; i++) {
+		step = 1 == i ? period : tiers[i - 1].span;
+		if (tiers[i - 1].allowed < 
+		    (size_t)((tiers[i].span + step - 1) / step))
+			errx(EXIT_FAILURE, "-a: %s retention too small "
+				"for %s", tierdefs[i - 1].name, 
+				tierdefs[i].name);
+	}
+
+	/*
+	 * By default, sample the process, command, and file counts
+	 * about every 15 seconds, as these are the most expensive to
+	 * collect.
+	 * Everything else is sampled every interval.
+	 */
+
+	for (c = 0; c < SYSRC__MAX; c++)
+		cfg.divs[c] = 1;
+	cfg.divs[SYSRC_PROCS] = cfg.divs[SYSRC_RPROCS] =
+		cfg.divs[SYSRC_FILES] = period < 15 ? 15 / period : 1;
+
+	if (NULL != sources && ! sources_parse(&cfg, sources))
+		goto usage;
+	if (NULL != bursts && ! burst_parse(&burst, bursts))
+		goto usage;
+
 	/* XXX: hack around ksql(3) exit when receives signal. */
 
 	if (SIG_ERR == signal(SIGINT, SIG_IGN))
@@ -376,10 +2546,36 @@ main(int argc, char *argv[])
 	if (SIG_ERR == signal(SIGTERM, SIG_IGN))
 		err(EXIT_FAILURE, "signal");
 
+	if (! noop && usewal && NULL == (wal = wal_open(dbfile)))
+		errx(EXIT_FAILURE, "%s", dbfile);
+
 	if (! noop && 
 	    (db = db_open_logging(dbfile, NULL, warnx, NULL)) == NULL)
 		errx(EXIT_FAILURE, "%s", dbfile);
 
+	/*
+	 * Read what's in the ring file, then replace it with an empty
+	 * one, as the retention may have changed.
+	 * Its records are put back when the tiers are loaded.
+	 * We're its only writer, so one that was killed while writing
+	 * doesn't stop us; and if it's unreadable, such as being from
+	 * another version, we simply start without it.
+	 * The quarter-minute and minute tiers are the first two.
+	 */
+
+	if (! noop && NULL != ringfile) {
+		if (ring_load(ringfile, 1, 
+		    &ringrecs, &ringdevs, &ringsz) < 0)
+			warn("%s: discarding", ringfile);
+		ring = ring_open(ringfile, 
+			tiers[0].allowed + 1, tiers[1].allowed + 1);
+		if (NULL == ring)
+			errx(EXIT_FAILURE, "%s", ringfile);
+		for (i = 0; i < TIER__MAX; i++)
+			if (ring_has(tiers[i].ival))
+				tiers[i].ring = ring;
+	}
+
 	/* FIXME: once we have unveil, this is moot. */
 
 #ifndef __linux__
@@ -482,51 +2678,159 @@ main(int argc, char *argv[])
 		goto out;
 	}
 
-	if (NULL != db && ! init(db, info))
+	if (NULL != db && ! init(db, info, period, 
+	    rollup, NULL != ring, &prevrollup))
+		goto out;
+	if ( ! metrics_init(db, info, &mids))
 		goto out;
+	if ( ! stages_init(db, &st))
+		goto out;
+	if ( ! tiers_chunk_init(tiers))
+		goto out;
+	if ( ! tiers_load(db, tiers, 
+	    ringrecs, ringdevs, ringsz, prevrollup))
+		goto out;
+	free(ringrecs);
+	ringrecs = NULL;
+
+	/* 
+	 * Newest records from before rollup mode don't line up with the
+	 * finer ones, so start anew.
+	 */
+
+	for (i = 0; rollup && ! prevrollup && i < TIER_SEC; i++)
+		tiers[i].seal = 1;
+	lastckpt = time(NULL);
 
 	if (verb)
 		printinit(info);
 
 	/*
 	 * Now enter our main loop.
-	 * The body will run every 15 seconds.
+	 * First take a priming sample so that rates (which are over the
+	 * time between samples) are valid in our first record.
+	 * Then the body will run every "period" seconds on the schedule.
 	 * Start each iteration by grabbing the current system state
 	 * using sysctl(3).
-	 * Then grab what we have in the database.
 	 * Lastly, modify the database state given our current.
 	 */
 
+	if ( ! sysinfo_update(&cfg, info))
+		goto out;
+	if ( ! sched_init(&sc, period))
+		goto out;
+
 	while ( ! doexit) {
+		/* Wait for our deadline or until we signal. */
+
+		if (-1 == (c = sched_wait(&sc, &sset)))
+			goto out;
+		else if (0 == c)
+			continue;
+
+		/* How long after the deadline we woke. */
+
+		late = sc.next;
+		late.tv_sec -= sc.step;
+		stage_end(&st.hist[STAGE_LATE], &late);
+
+		cfg.burst = 2 == c;
 		if ( ! sysinfo_update(&cfg, info))
 			goto out;
-		if (NULL != db) {
-			rq = db_record_list_lister(db);
-			update(db, info, rq);
-			db_record_freeq(rq);
-		} 
+		for (i = 0; i < SYSRC__MAX; i++)
+			if (sysinfo_get_took(info, i) >= 0.0)
+				stage_add(&st.hist[i],
+					sysinfo_get_took(info, i));
 		if (verb)
 			print(info);
-		
-		/* Wait 15 seconds or until we signal. */
+		if ( ! sample(info, mids, &rr, &det))
+			goto out;
+		dp = &det;
+
+		/*
+		 * While bursting, each sample is queued for the
+		 * per-second tier, written with the next regular
+		 * update, and keeps the burst going if over threshold.
+		 * At the regular deadline, their average is what goes
+		 * into the regular tiers, while their summaries are
+		 * kept whole.
+		 */
+
+		if (sc.step < period) {
+			record_add(&burst.acc, &rr);
+			if ( ! detail_add(&burst.det, &det))
+				goto out;
+			if (NULL != db && ! burst_push(&burst, &rr, &det))
+				goto out;
+			if (burst_hit(&burst, &rr))
+				burst.end = time(NULL) + burst.window;
+			if (2 == c)
+				continue;
+			record_avg(&rr, &burst.acc);
+			detail_scale(&burst.det, 1.0 / burst.acc.entries);
+			dp = &burst.det;
+			memset(&burst.acc, 0, sizeof(struct record));
+		}
 
-		if (-1 == ppoll(NULL, 0, &timeo, &sset) &&
-		    EINTR != errno) {
-			warn("ppoll");
+		flush = time(NULL) >= lastckpt + ckpt;
+		if (NULL != db && 
+		    ! update(db, &rr, dp, tiers, &burst, flush, rollup, &st))
 			goto out;
+		if (flush && verb)
+			stages_print(&st, sc.missed);
+		detail_clear(&burst.det);
+		if (flush && NULL != wal)
+			wal_checkpoint(wal, SQLITE_CHECKPOINT_PASSIVE);
+		if (flush && NULL != ring)
+			ring_sync(ring);
+		if (flush)
+			lastckpt = time(NULL);
+
+		/* Start or stop bursting only at regular deadlines. */
+
+		if (burst.window > 0 && period > 1) {
+			if (sc.step == period && burst_hit(&burst, &rr))
+				burst.end = time(NULL) + burst.window;
+			step = time(NULL) < burst.end ? 1 : period;
+			if (step != sc.step && ! sched_step(&sc, step))
+				goto out;
 		}
 	}
 
 	rc = 1;
 out:
+	if (NULL != db)
+		tiers_flush(db, tiers, &burst);
 	cfg_free(&cfg);
+	tiers_free(tiers);
+	detail_free(&det);
+	detail_free(&burst.det);
+	for (i = 0; i < burst.pendmax; i++)
+		detail_free(&burst.pend[i].det);
+	free(burst.pend);
+	sched_free(&sc);
+	free(mids);
+	free(ringrecs);
+	ring_close(ring);
 	sysinfo_free(info);
 	db_close(db);
+	if (NULL != wal) {
+		wal_checkpoint(wal, SQLITE_CHECKPOINT_TRUNCATE);
+		sqlite3_close(wal);
+	}
 	return rc ? EXIT_SUCCESS : EXIT_FAILURE;
 usage:
 	fprintf(stderr, "usage: %s "
-		"[-nv] "
+		"[-anVvw] "
+		"[-B burst] "
+		"[-c checkpoint] "
 		"[-d discs] "
-		"[-f dbfile]\n", getprogname());
+		"[-f dbfile] "
+		"[-H archive] "
+		"[-i interval] "
+		"[-p procs] "
+		"[-R ringfile] "
+		"[-r retention] "
+		"[-s sources]\n", getprogname());
 	return EXIT_FAILURE;
 }
@@ -17,6 +17,31 @@
 #ifndef SLANT_COLLECT_H
 #define SLANT_COLLECT_H
 
+/*
+ * Sources of system information, each of which may be sampled at its
+ * own rate.
+ */
+enum	sysrc {
+	SYSRC_CPU = 0, /* processor time */
+	SYSRC_MEM, /* memory */
+	SYSRC_NET, /* network interfaces */
+	SYSRC_DISC, /* discs */
+	SYSRC_PROCS, /* process counts */
+	SYSRC_RPROCS, /* monitored commands */
+	SYSRC_FILES, /* open files */
+	SYSRC__MAX
+};
+
+/*
+ * Resources with pressure stall information.
+ */
+enum	psirc {
+	PSI_CPU = 0,
+	PSI_MEM,
+	PSI_IO,
+	PSI__MAX
+};
+
 /*
  * Configuration of things we're going to look for.
  */
@@ -25,6 +50,30 @@ struct	syscfg {
 	size_t	  discsz;
 	char	**cmds; /* commands (e.g., httpd) */
 	size_t	  cmdsz;
+	size_t	  divs[SYSRC__MAX]; /* sample every n-th update */
+	int	  burst; /* between updates: only divisor of one */
+	int	  validate; /* cross-check counts the slow way */
+};
+
+#define	SYSDEV_NAMESZ 32
+
+/*
+ * Rates of one network interface or disc in the last sample.
+ */
+struct	sysdev {
+	char		 name[SYSDEV_NAMESZ]; /* device name */
+	int64_t		 rx; /* received or read bytes/second */
+	int64_t		 tx; /* transmitted or written bytes/second */
+};
+
+/*
+ * A metric that isn't a record field of its own, known by its name.
+ * These are stored by identifier, so a backend can add them without
+ * changing the database schema.
+ */
+struct	sysmetric {
+	const char	*name; /* unique name */
+	double		 value; /* value in last sample */
 };
 
 __BEGIN_DECLS
@@ -37,12 +86,39 @@ double		 sysinfo_get_cpu_avg(const struct sysinfo *);
 double		 sysinfo_get_mem_avg(const struct sysinfo *);
 int64_t		 sysinfo_get_nettx_avg(const struct sysinfo *);
 int64_t		 sysinfo_get_netrx_avg(const struct sysinfo *);
+int64_t		 sysinfo_get_nettxpkt_avg(const struct sysinfo *);
+int64_t		 sysinfo_get_netrxpkt_avg(const struct sysinfo *);
+double		 sysinfo_get_nettxerr_avg(const struct sysinfo *);
+double		 sysinfo_get_netrxerr_avg(const struct sysinfo *);
+double		 sysinfo_get_netcoll_avg(const struct sysinfo *);
 int64_t		 sysinfo_get_discread_avg(const struct sysinfo *);
 int64_t		 sysinfo_get_discwrite_avg(const struct sysinfo *);
+int64_t		 sysinfo_get_disciops_avg(const struct sysinfo *);
+double		 sysinfo_get_discawait_avg(const struct sysinfo *);
+double		 sysinfo_get_discbusy_avg(const struct sysinfo *);
+int64_t		 sysinfo_get_ctxt_avg(const struct sysinfo *);
+int64_t		 sysinfo_get_intr_avg(const struct sysinfo *);
+double		 sysinfo_get_procsrun(const struct sysinfo *);
+double		 sysinfo_get_procsblk(const struct sysinfo *);
+double		 sysinfo_get_load1(const struct sysinfo *);
+double		 sysinfo_get_load5(const struct sysinfo *);
+double		 sysinfo_get_load15(const struct sysinfo *);
+double		 sysinfo_get_psi_some(const struct sysinfo *, enum psirc);
+double		 sysinfo_get_psi_full(const struct sysinfo *, enum psirc);
 double		 sysinfo_get_nfiles(const struct sysinfo *);
 double		 sysinfo_get_nprocs(const struct sysinfo *);
 double		 sysinfo_get_rprocs(const struct sysinfo *);
 time_t		 sysinfo_get_boottime(const struct sysinfo *);
+size_t		 sysinfo_get_cores(const struct sysinfo *, 
+			const uint16_t **);
+size_t		 sysinfo_get_ifs(const struct sysinfo *,
+			const struct sysdev **);
+size_t		 sysinfo_get_discs(const struct sysinfo *,
+			const struct sysdev **);
+size_t		 sysinfo_get_metrics(const struct sysinfo *,
+			const struct sysmetric **);
+int		 sysinfo_get_stale(const struct sysinfo *, enum sysrc);
+double		 sysinfo_get_took(const struct sysinfo *, enum sysrc);
 
 __END_DECLS
 
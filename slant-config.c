@@ -282,7 +282,9 @@ static int
 parse_layout_rates(struct parse *p, unsigned int *val)
 {
 
-	if (tok_eq_adv(p, "qmin"))
+	if (tok_eq_adv(p, "sec"))
+		*val |= LINE_SEC;
+	else if (tok_eq_adv(p, "qmin"))
 		*val |= LINE_QMIN;
 	else if (tok_eq_adv(p, "min"))
 		*val |= LINE_MIN;
@@ -313,7 +315,9 @@ static int
 parse_layout_pcts(struct parse *p, unsigned int *val)
 {
 
-	if (tok_eq_adv(p, "qmin_bars"))
+	if (tok_eq_adv(p, "sec_bars"))
+		*val |= LINE_SEC_BARS;
+	else if (tok_eq_adv(p, "qmin_bars"))
 		*val |= LINE_QMIN_BARS;
 	else if (tok_eq_adv(p, "min_bars"))
 		*val |= LINE_MIN_BARS;
@@ -325,6 +329,8 @@ parse_layout_pcts(struct parse *p, unsigned int *val)
 		*val |= LINE_WEEK_BARS;
 	else if (tok_eq_adv(p, "year_bars"))
 		*val |= LINE_YEAR_BARS;
+	else if (tok_eq_adv(p, "sec"))
+		*val |= LINE_SEC;
 	else if (tok_eq_adv(p, "qmin"))
 		*val |= LINE_QMIN;
 	else if (tok_eq_adv(p, "min"))
@@ -384,8 +390,14 @@ parse_layout_host(struct parse *p, struct config *cfg)
 			b->cat = DRAWCAT_MEM;
 		else if (tok_eq_adv(p, "net"))
 			b->cat = DRAWCAT_NET;
+		else if (tok_eq_adv(p, "netpkt"))
+			b->cat = DRAWCAT_NETPKT;
+		else if (tok_eq_adv(p, "neterr"))
+			b->cat = DRAWCAT_NETERR;
 		else if (tok_eq_adv(p, "disc"))
 			b->cat = DRAWCAT_DISC;
+		else if (tok_eq_adv(p, "disclat"))
+			b->cat = DRAWCAT_DISCLAT;
 		else if (tok_eq_adv(p, "link"))
 			b->cat = DRAWCAT_LINK;
 		else if (tok_eq_adv(p, "host"))
@@ -396,7 +408,34 @@ parse_layout_host(struct parse *p, struct config *cfg)
 			b->cat = DRAWCAT_RPROCS;
 		else if (tok_eq_adv(p, "nfiles"))
 			b->cat = DRAWCAT_FILES;
-		else
+		else if (tok_eq_adv(p, "cores"))
+			b->cat = DRAWCAT_CORES;
+		else if (tok_eq_adv(p, "topnet"))
+			b->cat = DRAWCAT_TOPNET;
+		else if (tok_eq_adv(p, "topdisc"))
+			b->cat = DRAWCAT_TOPDISC;
+		else if (tok_eq_adv(p, "sched"))
+			b->cat = DRAWCAT_SCHED;
+		else if (tok_eq_adv(p, "runq"))
+			b->cat = DRAWCAT_RUNQ;
+		else if (tok_eq_adv(p, "load"))
+			b->cat = DRAWCAT_LOAD;
+		else if (tok_eq_adv(p, "psi"))
+			b->cat = DRAWCAT_PSI;
+		else if (tok_eq_adv(p, "psifull"))
+			b->cat = DRAWCAT_PSIFULL;
+		else if (tok_eq_adv(p, "metric")) {
+			b->cat = DRAWCAT_METRIC;
+			if (p->pos >= p->toksz) {
+				warnx("%s: unexpected eof", p->fn);
+				return 0;
+			}
+			b->metric = strdup(p->toks[p->pos++]);
+			if (NULL == b->metric) {
+				warn(NULL);
+				return 0;
+			}
+		} else
 			return tok_unknown(p);
 
 		/*
@@ -466,8 +505,20 @@ againline:
 					return rc;
 			}
 			break;
+		case DRAWCAT_CORES:
 		case DRAWCAT_DISC:
+		case DRAWCAT_DISCLAT:
+		case DRAWCAT_LOAD:
+		case DRAWCAT_METRIC:
 		case DRAWCAT_NET:
+		case DRAWCAT_NETERR:
+		case DRAWCAT_NETPKT:
+		case DRAWCAT_PSI:
+		case DRAWCAT_PSIFULL:
+		case DRAWCAT_RUNQ:
+		case DRAWCAT_SCHED:
+		case DRAWCAT_TOPDISC:
+		case DRAWCAT_TOPNET:
 			while (p->pos < p->toksz) {
 				rc = parse_layout_rates(p, line);
 				if (rc < 0)
@@ -802,8 +853,11 @@ config_free(struct config *cfg)
 
 	for (i = 0; i < cfg->urlsz; i++)
 		free(cfg->urls[i].url);
-	if (NULL != cfg->draw)
+	if (NULL != cfg->draw) {
+		for (i = 0; i < cfg->draw->boxsz; i++)
+			free(cfg->draw->box[i].metric);
 		free(cfg->draw->box);
+	}
 
 	free(cfg->draw);
 	free(cfg->urls);
@@ -48,6 +48,22 @@ static const char *const states[] = {
 	"read" /* STATE_READ */
 };
 
+/*
+ * Get the newest burst (per-second) record if the host is bursting,
+ * that is, if it's no older than the newest quarter-minute record.
+ * Return NULL if there's no burst.
+ */
+static const struct record *
+get_burst(const struct recset *r)
+{
+
+	if (NULL == r || 0 == r->bysecsz || 0 == r->bysec[0].entries)
+		return NULL;
+	if (r->byqminsz && r->byqmin[0].ctime > r->bysec[0].ctime)
+		return NULL;
+	return &r->bysec[0];
+}
+
 /*
  * Define a function for drawing rates.
  * This is a bit messy to functionify because of accessing the member
@@ -59,6 +75,24 @@ static void \
 _NAME(unsigned int bits, WINDOW *win, const struct node *n) \
 { \
 	double	 vv; \
+	const struct record *sec; \
+	if (LINE_SEC & bits) { \
+		bits &= ~LINE_SEC; \
+		if (NULL != (sec = get_burst(n->recs))) { \
+			vv = sec->_MEMRX / (double)sec->entries; \
+			wattron(win, A_BOLD); \
+			_DRAW_RATE(win, vv, 0); \
+			wattroff(win, A_BOLD); \
+			waddch(win, ':'); \
+			vv = sec->_MEMTX / (double)sec->entries; \
+			wattron(win, A_BOLD); \
+			_DRAW_RATE(win, vv, 1); \
+			wattroff(win, A_BOLD); \
+		} else \
+			waddstr(win, "------:------"); \
+		if (bits) \
+			draw_sub_separator(win); \
+	} \
 	if (LINE_QMIN & bits) { \
 		bits &= ~LINE_QMIN; \
 		if (NULL != n->recs && \
@@ -174,6 +208,17 @@ _NAME(unsigned int bits, WINDOW *win, const struct node *n) \
 { \
 	double	 vv; \
 	const struct recset *r = n->recs; \
+	const struct record *sec = get_burst(r); \
+	if (LINE_SEC_BARS & bits) { \
+		bits &= ~LINE_SEC_BARS; \
+		if (NULL != sec) { \
+			vv = sec->_MEMBER / sec->entries; \
+			draw_bars(win, vv); \
+		} else \
+			wprintw(win, "%10s", " "); \
+		if (bits) \
+			waddch(win, ' '); \
+	} \
 	if (LINE_QMIN_BARS & bits) { \
 		bits &= ~LINE_QMIN_BARS; \
 		if (NULL != r && \
@@ -246,6 +291,20 @@ _NAME(unsigned int bits, WINDOW *win, const struct node *n) \
 		if (bits) \
 			waddch(win, ' '); \
 	} \
+	if (LINE_SEC & bits) { \
+		bits &= ~LINE_SEC; \
+		if (NULL != sec) { \
+			vv = sec->_MEMBER / sec->entries; \
+			wattron(win, A_BOLD); \
+			_DRAW_PCT(win, vv); \
+			wattroff(win, A_BOLD); \
+		} else if (NULL != n->recs) { \
+			wprintw(win, "%6s", " "); \
+		} else  \
+			wprintw(win, "------%"); \
+		if (bits) \
+			draw_sub_separator(win); \
+	} \
 	if (LINE_QMIN & bits) { \
 		bits &= ~LINE_QMIN; \
 		if (NULL != r && \
@@ -338,6 +397,10 @@ size_rate(unsigned int bits)
 {
 	size_t	sz = 0;
 
+	if (LINE_SEC & bits) {
+		bits &= ~LINE_SEC;
+		sz += 13 + (bits ? 1 : 0);
+	}
 	if (LINE_QMIN & bits) {
 		bits &= ~LINE_QMIN;
 		sz += 13 + (bits ? 1 : 0);
@@ -367,6 +430,48 @@ size_rate(unsigned int bits)
 	return sz;
 }
 
+/*
+ * Get colunm widths of a box whose fields are all "w" wide.
+ * Used with draw_top() and draw_fixed().
+ */
+static size_t
+size_fixed(unsigned int bits, size_t w)
+{
+	size_t	sz = 0;
+
+	if (LINE_SEC & bits) {
+		bits &= ~LINE_SEC;
+		sz += w + (bits ? 1 : 0);
+	}
+	if (LINE_QMIN & bits) {
+		bits &= ~LINE_QMIN;
+		sz += w + (bits ? 1 : 0);
+	}
+	if (LINE_MIN & bits) {
+		bits &= ~LINE_MIN;
+		sz += w + (bits ? 1 : 0);
+	}
+	if (LINE_HOUR & bits) {
+		bits &= ~LINE_HOUR;
+		sz += w + (bits ? 1 : 0);
+	}
+	if (LINE_DAY & bits) {
+		bits &= ~LINE_DAY;
+		sz += w;
+	}
+	if (LINE_WEEK & bits) {
+		bits &= ~LINE_WEEK;
+		sz += w;
+	}
+	if (LINE_YEAR & bits) {
+		bits &= ~LINE_YEAR;
+		sz += w;
+	}
+
+	assert(0 == bits);
+	return sz;
+}
+
 /*
  * Get colunm widths of a percentage box.
  * Used with DEFINE_draw_pcts.
@@ -376,6 +481,10 @@ size_pct(unsigned int bits)
 {
 	size_t sz = 0;
 
+	if (LINE_SEC_BARS & bits) {
+		bits &= ~LINE_SEC_BARS;
+		sz += 10 + (bits ? 1 : 0);
+	}
 	if (LINE_QMIN_BARS & bits) {
 		bits &= ~LINE_QMIN_BARS;
 		sz += 10 + (bits ? 1 : 0);
@@ -400,6 +509,10 @@ size_pct(unsigned int bits)
 		bits &= ~LINE_YEAR_BARS;
 		sz += 10 + (bits ? 1 : 0);
 	}
+	if (LINE_SEC & bits) {
+		bits &= ~LINE_SEC;
+		sz += 6 + (bits ? 1 : 0);
+	}
 	if (LINE_QMIN & bits) {
 		bits &= ~LINE_QMIN;
 		sz += 6 + (bits ? 1 : 0);
@@ -499,6 +612,21 @@ size_link(const struct draw *d, unsigned int bits)
 	return sz;
 }
 
+/*
+ * Get the seconds between samples on the remote collector.
+ * Older servers don't report this, so assume 15 seconds.
+ */
+static time_t
+get_period(const struct node *n)
+{
+
+	if (NULL == n->recs || 
+	    ! n->recs->has_system ||
+	    n->recs->system.period <= 0)
+		return 15;
+	return n->recs->system.period;
+}
+
 /*
  * Return the last time for which we have some data.
  * This can come from any of the intervals.
@@ -509,10 +637,13 @@ size_link(const struct draw *d, unsigned int bits)
 static time_t
 get_last(const struct node *n)
 {
+	const struct record *sec;
 
 	if (NULL == n->recs)
 		return 0;
 
+	if (NULL != (sec = get_burst(n->recs)))
+		return sec->ctime;
 	if (n->recs->byqminsz &&
 	    n->recs->byqmin[0].entries)
 		return n->recs->byqmin[0].ctime;
@@ -852,6 +983,547 @@ draw_xfer(WINDOW *win, double vv, int left)
 		wprintw(win, "%6s", nbuf);
 }
 
+/*
+ * Like draw_xfer(), but for counts (packets, errors) in decimal units.
+ * Small rates, such as errors, keep a fractional digit.
+ */
+static void
+draw_count(WINDOW *win, double vv, int left)
+{
+	char	 nbuf[16];
+
+	if (vv >= 1000 * 1000 * 1000)
+		snprintf(nbuf, sizeof(nbuf), "%.1fG", vv / 1e9);
+	else if (vv >= 1000 * 1000)
+		snprintf(nbuf, sizeof(nbuf), "%.1fM", vv / 1e6);
+	else if (vv >= 1000)
+		snprintf(nbuf, sizeof(nbuf), "%.1fk", vv / 1e3);
+	else if (vv < 0.001)
+		snprintf(nbuf, sizeof(nbuf), "%g", 0.0);
+	else if (vv < 10)
+		snprintf(nbuf, sizeof(nbuf), "%.1f", vv);
+	else 
+		snprintf(nbuf, sizeof(nbuf), "%.0f", vv);
+
+	if (left)
+		wprintw(win, "%-6s", nbuf);
+	else
+		wprintw(win, "%6s", nbuf);
+}
+
+/*
+ * Draw the busiest core of a record's per-core times and the spread
+ * from it to the idlest core as "hot%:spread%".
+ * If "r" is NULL or has no per-core times, just draw dashes.
+ */
+static void
+draw_cores_rec(WINDOW *win, const struct record *r, int bold)
+{
+	const unsigned char *buf;
+	size_t		 i;
+	unsigned int	 v, min = 1000, max = 0;
+
+	if (NULL == r || 0 == r->entries || 
+	    ! r->has_cores || r->cores_sz < 2) {
+		waddstr(win, "------:------");
+		return;
+	}
+
+	buf = r->cores;
+	for (i = 0; i + 1 < r->cores_sz; i += 2) {
+		v = buf[i] | (buf[i + 1] << 8);
+		if (v < min)
+			min = v;
+		if (v > max)
+			max = v;
+	}
+
+	if (bold)
+		wattron(win, A_BOLD);
+	draw_pct(win, max / 10.0);
+	waddch(win, ':');
+	wprintw(win, "%5.1f%%", (max - min) / 10.0);
+	if (bold)
+		wattroff(win, A_BOLD);
+}
+
+/*
+ * Draw per-core times.
+ * Uses the same widths as DEFINE_draw_rates.
+ */
+static void
+draw_cores(unsigned int bits, WINDOW *win, const struct node *n)
+{
+	const struct recset *r = n->recs;
+
+	if (LINE_SEC & bits) {
+		bits &= ~LINE_SEC;
+		draw_cores_rec(win, get_burst(r), 1);
+		if (bits)
+			draw_sub_separator(win);
+	}
+	if (LINE_QMIN & bits) {
+		bits &= ~LINE_QMIN;
+		draw_cores_rec(win, NULL != r && r->byqminsz ?
+			&r->byqmin[0] : NULL, 1);
+		if (bits)
+			draw_sub_separator(win);
+	}
+	if (LINE_MIN & bits) {
+		bits &= ~LINE_MIN;
+		draw_cores_rec(win, NULL != r && r->byminsz ?
+			&r->bymin[0] : NULL, 0);
+		if (bits)
+			draw_sub_separator(win);
+	}
+	if (LINE_HOUR & bits) {
+		bits &= ~LINE_HOUR;
+		draw_cores_rec(win, NULL != r && r->byhoursz ?
+			&r->byhour[0] : NULL, 0);
+		if (bits)
+			draw_sub_separator(win);
+	}
+	if (LINE_DAY & bits) {
+		bits &= ~LINE_DAY;
+		draw_cores_rec(win, NULL != r && r->bydaysz ?
+			&r->byday[0] : NULL, 0);
+	}
+	if (LINE_WEEK & bits) {
+		bits &= ~LINE_WEEK;
+		draw_cores_rec(win, NULL != r && r->byweeksz ?
+			&r->byweek[0] : NULL, 0);
+	}
+	if (LINE_YEAR & bits) {
+		bits &= ~LINE_YEAR;
+		draw_cores_rec(win, NULL != r && r->byyearsz ?
+			&r->byyear[0] : NULL, 0);
+	}
+	assert(0 == bits);
+}
+
+/*
+ * Draw the name and combined rate of the busiest interface (or disc, if
+ * "disc" is set) of record "r" from the per-device rows of "rs".
+ * If there's no record or it has no devices, just draw dashes.
+ */
+static void
+draw_top_rec(WINDOW *win, const struct recset *rs, 
+	const struct record *r, int disc, int bold)
+{
+	const char	*name = NULL;
+	double		 vv, max = 0.0;
+	size_t		 i;
+
+	if (NULL != r && r->entries > 0 && disc) {
+		for (i = 0; i < rs->discsz; i++) {
+			if (rs->discs[i].recordid != r->id)
+				continue;
+			vv = rs->discs[i].discread + 
+				rs->discs[i].discwrite;
+			if (NULL == name || vv > max) {
+				name = rs->discs[i].name;
+				max = vv;
+			}
+		}
+	} else if (NULL != r && r->entries > 0) {
+		for (i = 0; i < rs->ifsz; i++) {
+			if (rs->ifs[i].recordid != r->id)
+				continue;
+			vv = rs->ifs[i].netrx + rs->ifs[i].nettx;
+			if (NULL == name || vv > max) {
+				name = rs->ifs[i].name;
+				max = vv;
+			}
+		}
+	}
+
+	if (NULL == name) {
+		waddstr(win, "-------- ------");
+		return;
+	}
+
+	if (bold)
+		wattron(win, A_BOLD);
+	wprintw(win, "%-8.8s ", name);
+	draw_xfer(win, max / r->entries, 0);
+	if (bold)
+		wattroff(win, A_BOLD);
+}
+
+/*
+ * Draw the one, five, and fifteen minute load averages of record "r".
+ * If there's no record, just draw dashes.
+ */
+static void
+draw_load_rec(WINDOW *win, const struct record *r, int bold)
+{
+	double	 v[3];
+	size_t	 i;
+
+	if (NULL == r || 0 == r->entries) {
+		waddstr(win, "------:------:------");
+		return;
+	}
+
+	v[0] = r->load1 / r->entries;
+	v[1] = r->load5 / r->entries;
+	v[2] = r->load15 / r->entries;
+
+	if (bold)
+		wattron(win, A_BOLD);
+	for (i = 0; i < 3; i++) {
+		if (i > 0)
+			waddch(win, ':');
+		if (v[i] >= 1000.0)
+			wprintw(win, "%6.0f", v[i]);
+		else
+			wprintw(win, "%6.2f", v[i]);
+	}
+	if (bold)
+		wattroff(win, A_BOLD);
+}
+
+/*
+ * Draw a pressure stall percentage.
+ * Unlike utilisation, even a little stalling is worth noticing.
+ */
+static void
+draw_psi_pct(WINDOW *win, double vv)
+{
+	if (vv >= 40.0)
+		wattron(win, COLOR_PAIR(2));
+	else if (vv >= 10.0)
+		wattron(win, COLOR_PAIR(1));
+	wprintw(win, "%5.1f%%", vv);
+	if (vv >= 40.0)
+		wattroff(win, COLOR_PAIR(2));
+	else if (vv >= 10.0)
+		wattroff(win, COLOR_PAIR(1));
+}
+
+/*
+ * Draw the processor, memory, and I/O pressure of record "r", either
+ * of some tasks or, if "full" is set, of all.
+ * If there's no record, just draw dashes.
+ */
+static void
+draw_psi_any(WINDOW *win, const struct record *r, int bold, int full)
+{
+
+	if (NULL == r || 0 == r->entries) {
+		waddstr(win, "------:------:------");
+		return;
+	}
+
+	if (bold)
+		wattron(win, A_BOLD);
+	draw_psi_pct(win, (full ? r->psicpufull : r->psicpusome) / 
+		r->entries);
+	waddch(win, ':');
+	draw_psi_pct(win, (full ? r->psimemfull : r->psimemsome) / 
+		r->entries);
+	waddch(win, ':');
+	draw_psi_pct(win, (full ? r->psiiofull : r->psiiosome) / 
+		r->entries);
+	if (bold)
+		wattroff(win, A_BOLD);
+}
+
+static void
+draw_psi_rec(WINDOW *win, const struct record *r, int bold)
+{
+
+	draw_psi_any(win, r, bold, 0);
+}
+
+static void
+draw_psifull_rec(WINDOW *win, const struct record *r, int bold)
+{
+
+	draw_psi_any(win, r, bold, 1);
+}
+
+/*
+ * Draw the I/O rate, average latency, and utilisation of the busiest
+ * disc of record "r" as "iops:await:busy".
+ * If there's no record, just draw dashes.
+ */
+static void
+draw_disclat_rec(WINDOW *win, const struct record *r, int bold)
+{
+	char	 buf[16];
+	double	 ms;
+
+	if (NULL == r || 0 == r->entries) {
+		waddstr(win, "------:------:------");
+		return;
+	}
+
+	ms = r->discawait / r->entries;
+	if (ms >= 1000.0)
+		snprintf(buf, sizeof(buf), "%.1fs", ms / 1000.0);
+	else if (ms >= 10.0)
+		snprintf(buf, sizeof(buf), "%.0fms", ms);
+	else
+		snprintf(buf, sizeof(buf), "%.1fms", ms);
+
+	if (bold)
+		wattron(win, A_BOLD);
+	draw_count(win, r->disciops / (double)r->entries, 0);
+	waddch(win, ':');
+	wprintw(win, "%6s", buf);
+	waddch(win, ':');
+	draw_pct(win, r->discbusy / r->entries);
+	if (bold)
+		wattroff(win, A_BOLD);
+}
+
+/*
+ * Draw the newest record of each interval with "fn", which is passed
+ * whether to embolden it.
+ * Used for boxes sized with size_fixed().
+ */
+static void
+draw_fixed(unsigned int bits, WINDOW *win, const struct node *n,
+	void (*fn)(WINDOW *, const struct record *, int))
+{
+	const struct recset *r = n->recs;
+
+	if (LINE_SEC & bits) {
+		bits &= ~LINE_SEC;
+		fn(win, get_burst(r), 1);
+		if (bits)
+			draw_sub_separator(win);
+	}
+	if (LINE_QMIN & bits) {
+		bits &= ~LINE_QMIN;
+		fn(win, NULL != r && r->byqminsz ?
+			&r->byqmin[0] : NULL, 1);
+		if (bits)
+			draw_sub_separator(win);
+	}
+	if (LINE_MIN & bits) {
+		bits &= ~LINE_MIN;
+		fn(win, NULL != r && r->byminsz ?
+			&r->bymin[0] : NULL, 0);
+		if (bits)
+			draw_sub_separator(win);
+	}
+	if (LINE_HOUR & bits) {
+		bits &= ~LINE_HOUR;
+		fn(win, NULL != r && r->byhoursz ?
+			&r->byhour[0] : NULL, 0);
+		if (bits)
+			draw_sub_separator(win);
+	}
+	if (LINE_DAY & bits) {
+		bits &= ~LINE_DAY;
+		fn(win, NULL != r && r->bydaysz ?
+			&r->byday[0] : NULL, 0);
+	}
+	if (LINE_WEEK & bits) {
+		bits &= ~LINE_WEEK;
+		fn(win, NULL != r && r->byweeksz ?
+			&r->byweek[0] : NULL, 0);
+	}
+	if (LINE_YEAR & bits) {
+		bits &= ~LINE_YEAR;
+		fn(win, NULL != r && r->byyearsz ?
+			&r->byyear[0] : NULL, 0);
+	}
+	assert(0 == bits);
+}
+
+/*
+ * Read an unsigned LEB128 number at "pos" of "buf", advancing "pos".
+ * Returns zero if truncated, non-zero on success.
+ */
+static int
+get_varint(const unsigned char *buf, size_t sz, size_t *pos, uint64_t *v)
+{
+	unsigned int	 shift;
+
+	for (*v = 0, shift = 0; *pos < sz && shift < 64; shift += 7) {
+		*v |= (uint64_t)(buf[*pos] & 0x7f) << shift;
+		if ( ! (buf[(*pos)++] & 0x80))
+			return 1;
+	}
+	return 0;
+}
+
+/*
+ * Look up the value of metric "id" in the "metrics" field of record
+ * "r": a version byte, the count, then identifier and value pairs.
+ * Returns zero if the record doesn't have it, non-zero otherwise.
+ */
+static int
+get_metric(const struct record *r, int64_t id, double *vv)
+{
+	const unsigned char *buf = r->metrics;
+	uint64_t	 n, v, i;
+	size_t		 pos = 1, j;
+
+	if ( ! r->has_metrics || 0 == r->metrics_sz || 1 != buf[0] ||
+	    ! get_varint(buf, r->metrics_sz, &pos, &n))
+		return 0;
+
+	for (i = 0; i < n; i++) {
+		if ( ! get_varint(buf, r->metrics_sz, &pos, &v) ||
+		    r->metrics_sz - pos < 8)
+			return 0;
+		if ((uint64_t)id != v) {
+			pos += 8;
+			continue;
+		}
+		for (v = 0, j = 0; j < 8; j++)
+			v |= (uint64_t)buf[pos + j] << (j * 8);
+		memcpy(vv, &v, sizeof(double));
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Draw the average of metric "name" in record "r", its identifier
+ * known from the metrics of "rs".
+ * If there's no record or it doesn't have the metric, draw dashes.
+ */
+static void
+draw_metric_rec(WINDOW *win, const struct recset *rs,
+	const struct record *r, const char *name, int bold)
+{
+	size_t	 i;
+	double	 v;
+
+	if (NULL == rs || NULL == r || 0 == r->entries) {
+		waddstr(win, "------");
+		return;
+	}
+	for (i = 0; i < rs->metricsz; i++)
+		if (0 == strcmp(rs->metrics[i].name, name))
+			break;
+	if (i == rs->metricsz || 
+	    ! get_metric(r, rs->metrics[i].id, &v)) {
+		waddstr(win, "------");
+		return;
+	}
+
+	if (bold)
+		wattron(win, A_BOLD);
+	draw_count(win, v / r->entries, 0);
+	if (bold)
+		wattroff(win, A_BOLD);
+}
+
+/*
+ * Draw a metric by "name" from the records' metrics.
+ * Sized with size_fixed().
+ */
+static void
+draw_metric(unsigned int bits, WINDOW *win, 
+	const struct node *n, const char *name)
+{
+	const struct recset *r = n->recs;
+
+	if (LINE_SEC & bits) {
+		bits &= ~LINE_SEC;
+		draw_metric_rec(win, r, get_burst(r), name, 1);
+		if (bits)
+			draw_sub_separator(win);
+	}
+	if (LINE_QMIN & bits) {
+		bits &= ~LINE_QMIN;
+		draw_metric_rec(win, r, NULL != r && r->byqminsz ?
+			&r->byqmin[0] : NULL, name, 1);
+		if (bits)
+			draw_sub_separator(win);
+	}
+	if (LINE_MIN & bits) {
+		bits &= ~LINE_MIN;
+		draw_metric_rec(win, r, NULL != r && r->byminsz ?
+			&r->bymin[0] : NULL, name, 0);
+		if (bits)
+			draw_sub_separator(win);
+	}
+	if (LINE_HOUR & bits) {
+		bits &= ~LINE_HOUR;
+		draw_metric_rec(win, r, NULL != r && r->byhoursz ?
+			&r->byhour[0] : NULL, name, 0);
+		if (bits)
+			draw_sub_separator(win);
+	}
+	if (LINE_DAY & bits) {
+		bits &= ~LINE_DAY;
+		draw_metric_rec(win, r, NULL != r && r->bydaysz ?
+			&r->byday[0] : NULL, name, 0);
+	}
+	if (LINE_WEEK & bits) {
+		bits &= ~LINE_WEEK;
+		draw_metric_rec(win, r, NULL != r && r->byweeksz ?
+			&r->byweek[0] : NULL, name, 0);
+	}
+	if (LINE_YEAR & bits) {
+		bits &= ~LINE_YEAR;
+		draw_metric_rec(win, r, NULL != r && r->byyearsz ?
+			&r->byyear[0] : NULL, name, 0);
+	}
+	assert(0 == bits);
+}
+
+/*
+ * Draw the busiest interface or disc.
+ * Only the newest record of each interval has its devices.
+ */
+static void
+draw_top(unsigned int bits, WINDOW *win, const struct node *n, int disc)
+{
+	const struct recset *r = n->recs;
+
+	if (LINE_SEC & bits) {
+		bits &= ~LINE_SEC;
+		draw_top_rec(win, r, get_burst(r), disc, 1);
+		if (bits)
+			draw_sub_separator(win);
+	}
+	if (LINE_QMIN & bits) {
+		bits &= ~LINE_QMIN;
+		draw_top_rec(win, r, NULL != r && r->byqminsz ?
+			&r->byqmin[0] : NULL, disc, 1);
+		if (bits)
+			draw_sub_separator(win);
+	}
+	if (LINE_MIN & bits) {
+		bits &= ~LINE_MIN;
+		draw_top_rec(win, r, NULL != r && r->byminsz ?
+			&r->bymin[0] : NULL, disc, 0);
+		if (bits)
+			draw_sub_separator(win);
+	}
+	if (LINE_HOUR & bits) {
+		bits &= ~LINE_HOUR;
+		draw_top_rec(win, r, NULL != r && r->byhoursz ?
+			&r->byhour[0] : NULL, disc, 0);
+		if (bits)
+			draw_sub_separator(win);
+	}
+	if (LINE_DAY & bits) {
+		bits &= ~LINE_DAY;
+		draw_top_rec(win, r, NULL != r && r->bydaysz ?
+			&r->byday[0] : NULL, disc, 0);
+	}
+	if (LINE_WEEK & bits) {
+		bits &= ~LINE_WEEK;
+		draw_top_rec(win, r, NULL != r && r->byweeksz ?
+			&r->byweek[0] : NULL, disc, 0);
+	}
+	if (LINE_YEAR & bits) {
+		bits &= ~LINE_YEAR;
+		draw_top_rec(win, r, NULL != r && r->byyearsz ?
+			&r->byyear[0] : NULL, disc, 0);
+	}
+	assert(0 == bits);
+}
+
 static void
 draw_host(unsigned int bits, const struct draw *d,
 	time_t timeo, time_t t, struct out *out, const struct node *n, 
@@ -865,7 +1537,7 @@ draw_host(unsigned int bits, const struct draw *d,
 		bits &= ~HOST_RECORD;
 		getyx(out->mainwin, y, x);
 		*lastrecord = x;
-		draw_interval(out->mainwin, 15, 
+		draw_interval(out->mainwin, get_period(n), 
 			n->waittime, get_last(n), t);
 		if (bits)
 			waddch(out->mainwin, ' ');
@@ -996,6 +1668,14 @@ DEFINE_draw_pcts(draw_cpu, cpu, draw_pct)
 
 DEFINE_draw_rates(draw_net, netrx, nettx, draw_xfer)
 
+DEFINE_draw_rates(draw_netpkt, netrxpkt, nettxpkt, draw_count)
+
+DEFINE_draw_rates(draw_neterr, netrxerr, nettxerr, draw_count)
+
+DEFINE_draw_rates(draw_sched, ctxt, intr, draw_count)
+
+DEFINE_draw_rates(draw_runq, procsrun, procsblk, draw_count)
+
 DEFINE_draw_rates(draw_disc, discread, discwrite, draw_xfer)
 
 static void
@@ -1040,10 +1720,28 @@ compute_width_box(const struct drawbox *box, unsigned int bits,
 	case DRAWCAT_RPROCS:
 		sz += size_pct(bits);
 		break;
+	case DRAWCAT_CORES:
 	case DRAWCAT_DISC:
 	case DRAWCAT_NET:
+	case DRAWCAT_NETERR:
+	case DRAWCAT_NETPKT:
+	case DRAWCAT_RUNQ:
+	case DRAWCAT_SCHED:
 		sz += size_rate(bits);
 		break;
+	case DRAWCAT_TOPDISC:
+	case DRAWCAT_TOPNET:
+		sz += size_fixed(bits, 15);
+		break;
+	case DRAWCAT_METRIC:
+		sz += size_fixed(bits, 6);
+		break;
+	case DRAWCAT_DISCLAT:
+	case DRAWCAT_LOAD:
+	case DRAWCAT_PSI:
+	case DRAWCAT_PSIFULL:
+		sz += size_fixed(bits, 20);
+		break;
 	case DRAWCAT_LINK:
 		sz += size_link(d, bits);
 		break;
@@ -1188,8 +1886,13 @@ draw_header_box(struct out *out,
 				box->len = box->lines[i].len;
 		}
 		break;
+	case DRAWCAT_CORES:
 	case DRAWCAT_DISC:
 	case DRAWCAT_NET:
+	case DRAWCAT_NETERR:
+	case DRAWCAT_NETPKT:
+	case DRAWCAT_RUNQ:
+	case DRAWCAT_SCHED:
 		for (i = 0; i < 6; i++) {
 			box->lines[i].len = 
 				size_rate(box->lines[i].line);
@@ -1197,6 +1900,34 @@ draw_header_box(struct out *out,
 				box->len = box->lines[i].len;
 		}
 		break;
+	case DRAWCAT_TOPDISC:
+	case DRAWCAT_TOPNET:
+		for (i = 0; i < 6; i++) {
+			box->lines[i].len = 
+				size_fixed(box->lines[i].line, 15);
+			if (box->lines[i].len > box->len)
+				box->len = box->lines[i].len;
+		}
+		break;
+	case DRAWCAT_METRIC:
+		for (i = 0; i < 6; i++) {
+			box->lines[i].len = 
+				size_fixed(box->lines[i].line, 6);
+			if (box->lines[i].len > box->len)
+				box->len = box->lines[i].len;
+		}
+		break;
+	case DRAWCAT_DISCLAT:
+	case DRAWCAT_LOAD:
+	case DRAWCAT_PSI:
+	case DRAWCAT_PSIFULL:
+		for (i = 0; i < 6; i++) {
+			box->lines[i].len = 
+				size_fixed(box->lines[i].line, 20);
+			if (box->lines[i].len > box->len)
+				box->len = box->lines[i].len;
+		}
+		break;
 	case DRAWCAT_LINK:
 		for (i = 0; i < 6; i++) {
 			box->lines[i].len = size_link
@@ -1246,6 +1977,22 @@ draw_header_box(struct out *out,
 			draw_centre(out->mainwin, 
 				"inet rx:tx", box->len);
 		break;
+	case DRAWCAT_NETPKT:
+		if (box->len < 12)
+			draw_centre(out->mainwin, 
+				"pkts", box->len);
+		else
+			draw_centre(out->mainwin, 
+				"pkts rx:tx", box->len);
+		break;
+	case DRAWCAT_NETERR:
+		if (box->len < 12)
+			draw_centre(out->mainwin, 
+				"errs", box->len);
+		else
+			draw_centre(out->mainwin, 
+				"errs in:out", box->len);
+		break;
 	case DRAWCAT_DISC:
 		if (box->len < 12)
 			draw_centre(out->mainwin, 
@@ -1254,6 +2001,76 @@ draw_header_box(struct out *out,
 			draw_centre(out->mainwin, 
 				"disc rd:wr", box->len);
 		break;
+	case DRAWCAT_DISCLAT:
+		if (box->len < 20)
+			draw_centre(out->mainwin, 
+				"disc lat", box->len);
+		else
+			draw_centre(out->mainwin, 
+				"disc iops:await:busy", box->len);
+		break;
+	case DRAWCAT_LOAD:
+		if (box->len < 20)
+			draw_centre(out->mainwin, 
+				"load", box->len);
+		else
+			draw_centre(out->mainwin, 
+				"load 1m:5m:15m", box->len);
+		break;
+	case DRAWCAT_PSI:
+		if (box->len < 20)
+			draw_centre(out->mainwin, 
+				"psi", box->len);
+		else
+			draw_centre(out->mainwin, 
+				"psi some cpu:mem:io", box->len);
+		break;
+	case DRAWCAT_PSIFULL:
+		if (box->len < 20)
+			draw_centre(out->mainwin, 
+				"psi full", box->len);
+		else
+			draw_centre(out->mainwin, 
+				"psi full cpu:mem:io", box->len);
+		break;
+	case DRAWCAT_RUNQ:
+		if (box->len < 12)
+			draw_centre(out->mainwin, 
+				"runq", box->len);
+		else
+			draw_centre(out->mainwin, 
+				"runq run:blk", box->len);
+		break;
+	case DRAWCAT_SCHED:
+		if (box->len < 12)
+			draw_centre(out->mainwin, 
+				"sched", box->len);
+		else
+			draw_centre(out->mainwin, 
+				"ctxt:intr", box->len);
+		break;
+	case DRAWCAT_CORES:
+		if (box->len < 13)
+			draw_centre(out->mainwin, 
+				"cores", box->len);
+		else
+			draw_centre(out->mainwin, 
+				"cores hot:sprd", box->len);
+		break;
+	case DRAWCAT_TOPNET:
+		draw_centre(out->mainwin, "top inet", box->len);
+		break;
+	case DRAWCAT_TOPDISC:
+		draw_centre(out->mainwin, "top disc", box->len);
+		break;
+	case DRAWCAT_METRIC:
+		if (strlen(box->metric) > box->len)
+			wprintw(out->mainwin, "%.*s", 
+				(int)box->len, box->metric);
+		else
+			draw_centre(out->mainwin, 
+				box->metric, box->len);
+		break;
 	case DRAWCAT_LINK:
 		if (box->len < 12)
 			draw_centre(out->mainwin, 
@@ -1340,9 +2157,33 @@ draw_box(struct out *out, const struct node *n, struct drawbox *box,
 	case DRAWCAT_NET:
 		draw_net(bits, out->mainwin, n);
 		break;
+	case DRAWCAT_NETPKT:
+		draw_netpkt(bits, out->mainwin, n);
+		break;
+	case DRAWCAT_NETERR:
+		draw_neterr(bits, out->mainwin, n);
+		break;
 	case DRAWCAT_DISC:
 		draw_disc(bits, out->mainwin, n);
 		break;
+	case DRAWCAT_DISCLAT:
+		draw_fixed(bits, out->mainwin, n, draw_disclat_rec);
+		break;
+	case DRAWCAT_LOAD:
+		draw_fixed(bits, out->mainwin, n, draw_load_rec);
+		break;
+	case DRAWCAT_PSI:
+		draw_fixed(bits, out->mainwin, n, draw_psi_rec);
+		break;
+	case DRAWCAT_PSIFULL:
+		draw_fixed(bits, out->mainwin, n, draw_psifull_rec);
+		break;
+	case DRAWCAT_RUNQ:
+		draw_runq(bits, out->mainwin, n);
+		break;
+	case DRAWCAT_SCHED:
+		draw_sched(bits, out->mainwin, n);
+		break;
 	case DRAWCAT_LINK:
 		draw_link(bits, d, n->waittime, t, 
 			out->mainwin, n, lastseen, box);
@@ -1360,6 +2201,18 @@ draw_box(struct out *out, const struct node *n, struct drawbox *box,
 	case DRAWCAT_FILES:
 		draw_files(bits, out->mainwin, n);
 		break;
+	case DRAWCAT_CORES:
+		draw_cores(bits, out->mainwin, n);
+		break;
+	case DRAWCAT_TOPNET:
+		draw_top(bits, out->mainwin, n, 0);
+		break;
+	case DRAWCAT_TOPDISC:
+		draw_top(bits, out->mainwin, n, 1);
+		break;
+	case DRAWCAT_METRIC:
+		draw_metric(bits, out->mainwin, n, box->metric);
+		break;
 	}
 
 	waddch(out->mainwin, ' ');
@@ -1452,7 +2305,8 @@ drawtimes(struct out *out, const struct draw *d,
 				wmove(out->mainwin, 
 					k + l + d->header, 
 					d->box[i].lines[l].lastrecord);
-				draw_interval(out->mainwin, 15, 
+				draw_interval(out->mainwin, 
+					get_period(&n[j]), 
 					n[j].waittime, 
 					get_last(&n[j]), t);
 			}
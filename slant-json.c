@@ -35,6 +35,31 @@
 #include "slant.h"
 #include "json.h"
 
+/*
+ * Count the tokens making up the value at "t", including nested
+ * objects and arrays, so that it can be skipped.
+ * Returns zero if the value runs past "toks".
+ */
+static int
+json_skip(const jsmntok_t *t, int toks)
+{
+	int	 i, j, rc;
+
+	if (toks < 1)
+		return 0;
+	if (JSMN_OBJECT != t[0].type && JSMN_ARRAY != t[0].type)
+		return 1;
+
+	for (i = 0, j = 1; i < t[0].size; i++) {
+		if (JSMN_OBJECT == t[0].type && ++j > toks)
+			return 0;
+		if (0 == (rc = json_skip(&t[j], toks - j)))
+			return 0;
+		j += rc;
+	}
+	return j;
+}
+
 /*
  * Parse the top-level objects of our JSON body.
  * Returns >1 on success, 0 on transient failure (malformatted), <0 on
@@ -121,9 +146,23 @@ json_parse_obj(struct out *out, const char *str,
 		return rc;
 	}
 
-	/* Now we do the qmin, min, hour, day, week, and year arrays. */
+	/*
+	 * Now we do the sec, qmin, min, hour, day, week, and year arrays,
+	 * then the per-device arrays.
+	 */
 
-	if (jsmn_eq(str, &t[pos], "qmin")) {
+	if (jsmn_eq(str, &t[pos], "sec")) {
+		if (n->recs->bysecsz) {
+			xwarnx(out, "JSON \"sec\" "
+				"duplicated: %s", n->host);
+			return 0;
+		}
+		pos++;
+		rc = jsmn_record_array
+			(&n->recs->bysec,
+			 &n->recs->bysecsz,
+			 str, &t[pos], toks - pos);
+	} else if (jsmn_eq(str, &t[pos], "qmin")) {
 		if (n->recs->byqminsz) {
 			xwarnx(out, "JSON \"qmin\" "
 				"duplicated: %s", n->host);
@@ -189,9 +228,44 @@ json_parse_obj(struct out *out, const char *str,
 			(&n->recs->byyear,
 			 &n->recs->byyearsz,
 			 str, &t[pos], toks - pos);
+	} else if (jsmn_eq(str, &t[pos], "ifs")) {
+		if (n->recs->ifsz) {
+			xwarnx(out, "JSON \"ifs\" "
+				"duplicated: %s", n->host);
+			return 0;
+		}
+		pos++;
+		rc = jsmn_ifrecord_array
+			(&n->recs->ifs,
+			 &n->recs->ifsz,
+			 str, &t[pos], toks - pos);
+	} else if (jsmn_eq(str, &t[pos], "discs")) {
+		if (n->recs->discsz) {
+			xwarnx(out, "JSON \"discs\" "
+				"duplicated: %s", n->host);
+			return 0;
+		}
+		pos++;
+		rc = jsmn_discrecord_array
+			(&n->recs->discs,
+			 &n->recs->discsz,
+			 str, &t[pos], toks - pos);
+	} else if (jsmn_eq(str, &t[pos], "metrics")) {
+		if (n->recs->metricsz) {
+			xwarnx(out, "JSON \"metrics\" "
+				"duplicated: %s", n->host);
+			return 0;
+		}
+		pos++;
+		rc = jsmn_metric_array
+			(&n->recs->metrics,
+			 &n->recs->metricsz,
+			 str, &t[pos], toks - pos);
 	} else {
-		xwarnx(out, "unknown JSON node: %s", n->host);
-		return 0;
+		/* Skip nodes from newer servers. */
+		if (0 == (rc = json_skip(&t[pos + 1], toks - pos - 1)))
+			xwarnx(out, "malformed JSON node: %s", n->host);
+		return rc;
 	}
 
 	if (0 == rc) 
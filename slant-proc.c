@@ -0,0 +1,393 @@
+/*	$Id$ */
+/*
+ * Copyright (c) 2018 Kristaps Dzonsons <kristaps@bsd.lv>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include "config.h"
+
+#include <ctype.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "slant-proc.h"
+
+/*
+ * The following are single-pass tokenisers for the /proc files we read.
+ * They walk the buffer once, pull out only the fields we use, and don't
+ * copy anything: names are NUL-terminated in place within the buffer.
+ * All take an "end" pointer, though our buffers are also NUL-terminated.
+ */
+
+/*
+ * Skip horizontal white-space starting at "cp".
+ */
+static char *
+tok_ws(char *cp, const char *end)
+{
+
+	while (cp < end && (' ' == *cp || '\t' == *cp))
+		cp++;
+	return cp;
+}
+
+/*
+ * Advance past the end of the current line.
+ */
+char *
+tok_eol(char *cp, const char *end)
+{
+
+	while (cp < end && '\n' != *cp)
+		cp++;
+	return cp < end ? cp + 1 : cp;
+}
+
+/*
+ * Parse an unsigned decimal number following optional white-space,
+ * advancing "cpp" past it.
+ * Returns zero if there is no number, non-zero on success.
+ */
+int
+tok_u64(char **cpp, const char *end, uint64_t *v)
+{
+	char	*cp = tok_ws(*cpp, end);
+	uint64_t val = 0;
+
+	if (cp == end || *cp < '0' || *cp > '9')
+		return 0;
+	while (cp < end && *cp >= '0' && *cp <= '9')
+		val = val * 10 + (*cp++ - '0');
+	*cpp = cp;
+	*v = val;
+	return 1;
+}
+
+/*
+ * Parse an unsigned decimal number such as "1.25" into "v".
+ * Returns zero if there's no number, non-zero on success.
+ */
+int
+tok_real(char **cpp, const char *end, double *v)
+{
+	char	*cp = tok_ws(*cpp, end);
+	double	 val = 0.0, scale = 1.0;
+
+	if (cp == end || *cp < '0' || *cp > '9')
+		return 0;
+	while (cp < end && *cp >= '0' && *cp <= '9')
+		val = val * 10.0 + (*cp++ - '0');
+	if (cp < end && '.' == *cp)
+		for (cp++; cp < end && *cp >= '0' && *cp <= '9'; ) {
+			scale /= 10.0;
+			val += (*cp++ - '0') * scale;
+		}
+	*cpp = cp;
+	*v = val;
+	return 1;
+}
+
+/*
+ * Parse "sz" unsigned numbers into "v", skipping those whose bit is not
+ * set in "mask".
+ * Returns zero if fewer than "sz" numbers are found, non-zero on
+ * success.
+ */
+static int
+tok_u64s(char **cpp, const char *end, 
+	uint64_t *v, size_t sz, unsigned int mask)
+{
+	size_t	 i;
+	uint64_t val;
+
+	for (i = 0; i < sz; i++) {
+		if ( ! tok_u64(cpp, end, &val))
+			return 0;
+		if (mask & (1U << i))
+			*v++ = val;
+	}
+	return 1;
+}
+
+/*
+ * Parse the aggregate "cpu" line at the start of /proc/stat.
+ * Older kernels have fewer than CPUSTATES fields: the missing ones are
+ * left at zero.
+ * Returns zero on parse failure, non-zero on success.
+ */
+int
+parse_stat(char *buf, size_t sz, uint64_t *cp_time)
+{
+	char		*cp = buf;
+	const char	*end = buf + sz;
+	size_t		 i;
+
+	if (sz < 4 || strncmp(cp, "cpu ", 4))
+		return 0;
+	cp += 4;
+	for (i = 0; i < CPUSTATES; i++)
+		if ( ! tok_u64(&cp, end, &cp_time[i]))
+			break;
+	if (i <= CP_IDLE)
+		return 0;
+	for (; i < CPUSTATES; i++)
+		cp_time[i] = 0;
+	return 1;
+}
+
+/*
+ * Parse the next per-core "cpuN" line of /proc/stat, which follow the
+ * aggregate line, setting "idx" to N.
+ * Returns >0 if a line was parsed, 0 if there are no more, and <0 on
+ * parse failure.
+ */
+int
+parse_stat_core(char **cpp, const char *end, 
+	size_t *idx, uint64_t *cp_time)
+{
+	char		*cp = *cpp;
+	uint64_t	 n;
+	size_t		 i;
+
+	if (end - cp < 4 || strncmp(cp, "cpu", 3) || 
+	    ! isdigit((unsigned char)cp[3]))
+		return 0;
+	cp += 3;
+	if ( ! tok_u64(&cp, end, &n) || n >= 65536)
+		return -1;
+	for (i = 0; i < CPUSTATES; i++)
+		if ( ! tok_u64(&cp, end, &cp_time[i]))
+			break;
+	if (i <= CP_IDLE)
+		return -1;
+	for (; i < CPUSTATES; i++)
+		cp_time[i] = 0;
+	*idx = n;
+	*cpp = tok_eol(cp, end);
+	return 1;
+}
+
+/*
+ * Parse the "ctxt", "intr", "procs_running", and "procs_blocked" lines
+ * of /proc/stat, which follow the per-core lines.
+ * Of "intr", only the leading total is used.
+ * Returns zero on parse failure, non-zero on success.
+ */
+int
+parse_stat_misc(char *buf, size_t sz, uint64_t *ctxt, 
+	uint64_t *intr, uint64_t *run, uint64_t *blk)
+{
+	char		*cp = buf;
+	const char	*end = buf + sz;
+	int		 found = 0;
+
+	while (cp < end && 0xf != found) {
+		if (0 == strncmp(cp, "intr ", 5)) {
+			cp += 5;
+			if ( ! tok_u64(&cp, end, intr))
+				return 0;
+			found |= 0x1;
+		} else if (0 == strncmp(cp, "ctxt ", 5)) {
+			cp += 5;
+			if ( ! tok_u64(&cp, end, ctxt))
+				return 0;
+			found |= 0x2;
+		} else if (0 == strncmp(cp, "procs_running ", 14)) {
+			cp += 14;
+			if ( ! tok_u64(&cp, end, run))
+				return 0;
+			found |= 0x4;
+		} else if (0 == strncmp(cp, "procs_blocked ", 14)) {
+			cp += 14;
+			if ( ! tok_u64(&cp, end, blk))
+				return 0;
+			found |= 0x8;
+		}
+		cp = tok_eol(cp, end);
+	}
+
+	return 0xf == found;
+}
+
+/*
+ * Parse a /proc/pressure file for the ten-second averages of the
+ * "some" and "full" lines.
+ * Older kernels have no "full" line for processors: it's left at zero.
+ * Returns zero on parse failure, non-zero on success.
+ */
+int
+parse_psi(char *buf, size_t sz, double *some, double *full)
+{
+	char		*cp = buf;
+	const char	*end = buf + sz;
+	int		 found = 0;
+
+	*some = *full = 0.0;
+	while (cp < end) {
+		if (0 == strncmp(cp, "some avg10=", 11)) {
+			cp += 11;
+			if ( ! tok_real(&cp, end, some))
+				return 0;
+			found = 1;
+		} else if (0 == strncmp(cp, "full avg10=", 11)) {
+			cp += 11;
+			if ( ! tok_real(&cp, end, full))
+				return 0;
+		}
+		cp = tok_eol(cp, end);
+	}
+
+	return found;
+}
+
+/*
+ * Parse /proc/meminfo for the total, free, and available memory and
+ * the swap space.
+ * We stop as soon as we have all of them instead of scanning the rest.
+ * Only the total and free memory are required: older kernels don't
+ * have the available memory, and its value is then the free memory.
+ * Returns zero on parse failure, non-zero on success.
+ */
+int
+parse_meminfo(char *buf, size_t sz, struct meminfo *mi)
+{
+	char		*cp = buf;
+	const char	*end = buf + sz;
+	int		 found = 0;
+
+	memset(mi, 0, sizeof(struct meminfo));
+
+	while (cp < end && 0x1f != found) {
+		if (0 == strncmp(cp, "MemTotal:", 9)) {
+			cp += 9;
+			if ( ! tok_u64(&cp, end, &mi->total))
+				return 0;
+			found |= 0x1;
+		} else if (0 == strncmp(cp, "MemFree:", 8)) {
+			cp += 8;
+			if ( ! tok_u64(&cp, end, &mi->free))
+				return 0;
+			found |= 0x2;
+		} else if (0 == strncmp(cp, "MemAvailable:", 13)) {
+			cp += 13;
+			if ( ! tok_u64(&cp, end, &mi->avail))
+				return 0;
+			found |= 0x4;
+		} else if (0 == strncmp(cp, "SwapTotal:", 10)) {
+			cp += 10;
+			if ( ! tok_u64(&cp, end, &mi->swaptotal))
+				return 0;
+			found |= 0x8;
+		} else if (0 == strncmp(cp, "SwapFree:", 9)) {
+			cp += 9;
+			if ( ! tok_u64(&cp, end, &mi->swapfree))
+				return 0;
+			found |= 0x10;
+		}
+		cp = tok_eol(cp, end);
+	}
+	if ( ! (0x4 & found))
+		mi->avail = mi->free;
+	return 0x3 == (0x3 & found);
+}
+
+/*
+ * Parse the next interface line of /proc/net/dev, which must already
+ * be past the two header lines.
+ * The interface name is NUL-terminated in place and set in "name".
+ * Returns >0 if a line was parsed, 0 at the end of the buffer, and <0
+ * on parse failure.
+ */
+int
+parse_netdev(char **cpp, const char *end, 
+	char **name, struct ifcount *ifc)
+{
+	char	*cp = tok_ws(*cpp, end);
+	uint64_t v[7];
+
+	if (cp == end)
+		return 0;
+
+	*name = cp;
+	while (cp < end && ':' != *cp && '\n' != *cp)
+		cp++;
+	if (cp == end || ':' != *cp)
+		return -1;
+	*cp++ = '\0';
+
+	/*
+	 * Sixteen fields: we want rx-bytes, rx-packets, rx-errors,
+	 * tx-bytes, tx-packets, tx-errors, and tx-collisions.
+	 */
+
+	if ( ! tok_u64s(&cp, end, v, 16, 0x2707))
+		return -1;
+
+	ifc->ifc_ib = v[0];
+	ifc->ifc_ip = v[1];
+	ifc->ifc_ie = v[2];
+	ifc->ifc_ob = v[3];
+	ifc->ifc_op = v[4];
+	ifc->ifc_oe = v[5];
+	ifc->ifc_co = v[6];
+
+	*cpp = tok_eol(cp, end);
+	return 1;
+}
+
+/*
+ * Parse the next line of /proc/diskstats for the device name (which is
+ * NUL-terminated in place) and its counters.
+ * Returns >0 if a line was parsed, 0 at the end of the buffer, and <0
+ * on parse failure.
+ */
+int
+parse_diskstats(char **cpp, const char *end, 
+	char **name, struct discio *io)
+{
+	char	*cp = tok_ws(*cpp, end);
+	uint64_t v[9];
+
+	if (cp == end)
+		return 0;
+
+	/* Major and minor numbers. */
+
+	if ( ! tok_u64s(&cp, end, v, 2, 0))
+		return -1;
+
+	cp = tok_ws(cp, end);
+	*name = cp;
+	while (cp < end && ' ' != *cp && '\t' != *cp && '\n' != *cp)
+		cp++;
+	if (cp == *name || cp == end || '\n' == *cp)
+		return -1;
+	*cp++ = '\0';
+
+	/* 
+	 * Following the name are reads completed, reads merged,
+	 * sectors read, and ms reading; the same four for writes; I/Os
+	 * in progress, which we skip; then ms doing I/O.
+	 */
+
+	if ( ! tok_u64s(&cp, end, v, 10, 0x2ff))
+		return -1;
+
+	io->secrd = v[2];
+	io->secwr = v[6];
+	io->ios = v[0] + v[4];
+	io->ticks = v[3] + v[7];
+	io->busy = v[8];
+	*cpp = tok_eol(cp, end);
+	return 1;
+}
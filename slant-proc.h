@@ -0,0 +1,88 @@
+/*	$Id$ */
+/*
+ * Copyright (c) 2018 Kristaps Dzonsons <kristaps@bsd.lv>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef SLANT_PROC_H
+#define SLANT_PROC_H
+
+/*
+ * Single-pass tokenisers for the Linux /proc files, kept apart from
+ * the collector so that slant-bench can measure them.
+ */
+
+/*
+ * /proc/stat
+ */
+#define CP_USER 0
+#define CP_NICE 1
+#define CP_SYS 2
+#define CP_IDLE 3
+#define CP_IOWAIT 4
+#define CP_IRQ 5
+#define CP_SOFTIRQ 6
+#define CP_STEAL 7
+#define CP_GUEST 8
+#define CP_GUEST_NICE 9
+#define CPUSTATES 10
+
+/*
+ * What we read from /proc/meminfo, in KiB.
+ */
+struct	meminfo {
+	uint64_t	 total; /* MemTotal */
+	uint64_t	 free; /* MemFree */
+	uint64_t	 avail; /* MemAvailable (since Linux 3.14) */
+	uint64_t	 swaptotal; /* SwapTotal */
+	uint64_t	 swapfree; /* SwapFree */
+};
+
+/*
+ * Counters of one line of /proc/diskstats.
+ */
+struct	discio {
+	uint64_t	 secrd; /* sectors read */
+	uint64_t	 secwr; /* sectors written */
+	uint64_t	 ios; /* reads and writes completed */
+	uint64_t	 ticks; /* ms spent in reads and writes */
+	uint64_t	 busy; /* ms doing I/O at all */
+};
+
+struct 	ifcount {
+	uint64_t	ifc_ib;			/* input bytes */
+	uint64_t	ifc_ip;			/* input packets */
+	uint64_t	ifc_ie;			/* input errors */
+	uint64_t	ifc_ob;			/* output bytes */
+	uint64_t	ifc_op;			/* output packets */
+	uint64_t	ifc_oe;			/* output errors */
+	uint64_t	ifc_co;			/* collisions */
+};
+
+__BEGIN_DECLS
+
+char	*tok_eol(char *, const char *);
+int	 tok_u64(char **, const char *, uint64_t *);
+int	 tok_real(char **, const char *, double *);
+int	 parse_stat(char *, size_t, uint64_t *);
+int	 parse_stat_core(char **, const char *, size_t *, uint64_t *);
+int	 parse_stat_misc(char *, size_t, uint64_t *, 
+		uint64_t *, uint64_t *, uint64_t *);
+int	 parse_psi(char *, size_t, double *, double *);
+int	 parse_meminfo(char *, size_t, struct meminfo *);
+int	 parse_netdev(char **, const char *, char **, struct ifcount *);
+int	 parse_diskstats(char **, const char *, char **, struct discio *);
+
+__END_DECLS
+
+#endif /* ! SLANT_PROC_H */
@@ -0,0 +1,640 @@
+/*	$Id$ */
+/*
+ * Copyright (c) 2018 Kristaps Dzonsons <kristaps@bsd.lv>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include "config.h"
+
+#if HAVE_SYS_QUEUE
+# include <sys/queue.h>
+#endif
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if HAVE_ERR
+# include <err.h>
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "extern.h"
+#include "slant-ring.h"
+
+#define	RING_MAGIC "slantrng"
+#define	RING_VERSION 2
+#define	RING_TIERS 2
+
+/*
+ * Bytes of each slot for the record's per-device rows, summary,
+ * cores, and metrics.
+ * Whatever doesn't fit is left out.
+ */
+#define	RING_DETAILSZ 4096
+
+/*
+ * Times a reader retries while the writer is busy before giving up,
+ * yielding the processor each time.
+ */
+#define	RING_TRIES 1000
+
+/*
+ * Intervals kept in the ring, in file order.
+ */
+static	const enum interval ringivals[RING_TIERS] = {
+	INTERVAL_byqmin,
+	INTERVAL_bymin,
+};
+
+/*
+ * One record in the file.
+ * Every field but the detail is eight bytes, so there's no padding.
+ * The detail has the interface then disc rows (as struct ringdev), then
+ * the summary, cores, and metrics blobs.
+ * Values are in host byte order: the file isn't portable.
+ */
+struct	ringslot {
+	int64_t		 ctime;
+	int64_t		 entries;
+	double		 cpu;
+	double		 mem;
+	int64_t		 nettx;
+	int64_t		 netrx;
+	int64_t		 nettxpkt;
+	int64_t		 netrxpkt;
+	double		 nettxerr;
+	double		 netrxerr;
+	double		 netcoll;
+	int64_t		 discread;
+	int64_t		 discwrite;
+	int64_t		 disciops;
+	double		 discawait;
+	double		 discbusy;
+	double		 nprocs;
+	double		 rprocs;
+	double		 nfiles;
+	int64_t		 ctxt;
+	int64_t		 intr;
+	double		 procsrun;
+	double		 procsblk;
+	double		 load1;
+	double		 load5;
+	double		 load15;
+	double		 psicpusome;
+	double		 psicpufull;
+	double		 psimemsome;
+	double		 psimemfull;
+	double		 psiiosome;
+	double		 psiiofull;
+	uint64_t	 ifsz; /* interface rows in detail */
+	uint64_t	 discsz; /* disc rows in detail */
+	uint64_t	 summary_sz; /* bytes of summary or 0 if null */
+	uint64_t	 cores_sz; /* bytes of cores or 0 if null */
+	uint64_t	 metrics_sz; /* bytes of metrics or 0 if null */
+	unsigned char	 detail[RING_DETAILSZ];
+};
+
+/*
+ * Position of one interval's records in the file.
+ */
+struct	ringtier {
+	int64_t		 ival; /* enum interval */
+	uint64_t	 slots; /* number of slots */
+	uint64_t	 start; /* slot of oldest record */
+	uint64_t	 size; /* number of records */
+};
+
+/*
+ * Start of the file, followed by the slots of each tier in order.
+ * The geometry (all but "seq", "start", and "size") never changes
+ * once the file is created: the collector instead replaces the file.
+ */
+struct	ringhdr {
+	char		 magic[8]; /* RING_MAGIC without nil */
+	uint32_t	 version; /* RING_VERSION */
+	uint32_t	 slotsz; /* sizeof(struct ringslot) */
+	volatile uint64_t seq; /* odd while writing */
+	struct ringtier	 tiers[RING_TIERS];
+};
+
+struct	ring {
+	struct ringhdr	*hdr; /* start of mapping */
+	struct ringslot	*slots[RING_TIERS]; /* slots of each tier */
+	size_t		 sz; /* size of mapping */
+};
+
+/*
+ * Append the blob "v" of "sz" bytes, if "has" and it fits within the
+ * "left" bytes at "p".
+ * Returns the bytes appended.
+ */
+static uint64_t
+slot_blob(unsigned char **p, size_t *left, 
+	int has, const void *v, size_t sz)
+{
+
+	if ( ! has || sz > *left)
+		return 0;
+	memcpy(*p, v, sz);
+	*p += sz;
+	*left -= sz;
+	return sz;
+}
+
+/*
+ * Fill "s" with "r" and its per-device rows "d", which may be NULL.
+ */
+static void
+slot_put(struct ringslot *s, const struct record *r, 
+	const struct ringdevs *d)
+{
+	unsigned char	*p = s->detail;
+	size_t		 left = RING_DETAILSZ;
+
+	s->ctime = r->ctime;
+	s->entries = r->entries;
+	s->cpu = r->cpu;
+	s->mem = r->mem;
+	s->nettx = r->nettx;
+	s->netrx = r->netrx;
+	s->nettxpkt = r->nettxpkt;
+	s->netrxpkt = r->netrxpkt;
+	s->nettxerr = r->nettxerr;
+	s->netrxerr = r->netrxerr;
+	s->netcoll = r->netcoll;
+	s->discread = r->discread;
+	s->discwrite = r->discwrite;
+	s->disciops = r->disciops;
+	s->discawait = r->discawait;
+	s->discbusy = r->discbusy;
+	s->nprocs = r->nprocs;
+	s->rprocs = r->rprocs;
+	s->nfiles = r->nfiles;
+	s->ctxt = r->ctxt;
+	s->intr = r->intr;
+	s->procsrun = r->procsrun;
+	s->procsblk = r->procsblk;
+	s->load1 = r->load1;
+	s->load5 = r->load5;
+	s->load15 = r->load15;
+	s->psicpusome = r->psicpusome;
+	s->psicpufull = r->psicpufull;
+	s->psimemsome = r->psimemsome;
+	s->psimemfull = r->psimemfull;
+	s->psiiosome = r->psiiosome;
+	s->psiiofull = r->psiiofull;
+
+	s->ifsz = s->discsz = 0;
+	if (NULL != d && 
+	    d->ifsz + d->discsz <= left / sizeof(struct ringdev)) {
+		memcpy(p, d->ifs, d->ifsz * sizeof(struct ringdev));
+		p += d->ifsz * sizeof(struct ringdev);
+		memcpy(p, d->discs, d->discsz * sizeof(struct ringdev));
+		p += d->discsz * sizeof(struct ringdev);
+		left -= (d->ifsz + d->discsz) * sizeof(struct ringdev);
+		s->ifsz = d->ifsz;
+		s->discsz = d->discsz;
+	}
+	s->summary_sz = slot_blob(&p, &left, 
+		r->has_summary, r->summary, r->summary_sz);
+	s->cores_sz = slot_blob(&p, &left, 
+		r->has_cores, r->cores, r->cores_sz);
+	s->metrics_sz = slot_blob(&p, &left, 
+		r->has_metrics, r->metrics, r->metrics_sz);
+}
+
+/*
+ * Fill "r" and its per-device rows "d" from "s", copying the detail
+ * into "buf" of RING_DETAILSZ bytes, suitably aligned.
+ * Returns zero if the detail is malformed, non-zero on success.
+ */
+static int
+slot_get(struct record *r, struct ringdevs *d, 
+	const struct ringslot *s, unsigned char *buf)
+{
+	struct ringdev	*dev;
+	size_t		 i;
+
+	if (s->ifsz > RING_DETAILSZ / sizeof(struct ringdev) ||
+	    s->discsz > RING_DETAILSZ / sizeof(struct ringdev) ||
+	    s->summary_sz > RING_DETAILSZ ||
+	    s->cores_sz > RING_DETAILSZ ||
+	    s->metrics_sz > RING_DETAILSZ ||
+	    (s->ifsz + s->discsz) * sizeof(struct ringdev) + 
+	    s->summary_sz + s->cores_sz + s->metrics_sz > RING_DETAILSZ)
+		return 0;
+
+	memset(r, 0, sizeof(struct record));
+	r->ctime = s->ctime;
+	r->entries = s->entries;
+	r->cpu = s->cpu;
+	r->mem = s->mem;
+	r->nettx = s->nettx;
+	r->netrx = s->netrx;
+	r->nettxpkt = s->nettxpkt;
+	r->netrxpkt = s->netrxpkt;
+	r->nettxerr = s->nettxerr;
+	r->netrxerr = s->netrxerr;
+	r->netcoll = s->netcoll;
+	r->discread = s->discread;
+	r->discwrite = s->discwrite;
+	r->disciops = s->disciops;
+	r->discawait = s->discawait;
+	r->discbusy = s->discbusy;
+	r->nprocs = s->nprocs;
+	r->rprocs = s->rprocs;
+	r->nfiles = s->nfiles;
+	r->ctxt = s->ctxt;
+	r->intr = s->intr;
+	r->procsrun = s->procsrun;
+	r->procsblk = s->procsblk;
+	r->load1 = s->load1;
+	r->load5 = s->load5;
+	r->load15 = s->load15;
+	r->psicpusome = s->psicpusome;
+	r->psicpufull = s->psicpufull;
+	r->psimemsome = s->psimemsome;
+	r->psimemfull = s->psimemfull;
+	r->psiiosome = s->psiiosome;
+	r->psiiofull = s->psiiofull;
+
+	memcpy(buf, s->detail, RING_DETAILSZ);
+	dev = (struct ringdev *)buf;
+	for (i = 0; i < s->ifsz + s->discsz; i++)
+		dev[i].name[sizeof(dev[i].name) - 1] = '\0';
+	d->ifs = dev;
+	d->ifsz = s->ifsz;
+	d->discs = dev + s->ifsz;
+	d->discsz = s->discsz;
+	buf += (s->ifsz + s->discsz) * sizeof(struct ringdev);
+
+	if ((r->has_summary = s->summary_sz > 0)) {
+		r->summary = buf;
+		r->summary_sz = s->summary_sz;
+		buf += s->summary_sz;
+	}
+	if ((r->has_cores = s->cores_sz > 0)) {
+		r->cores = buf;
+		r->cores_sz = s->cores_sz;
+		buf += s->cores_sz;
+	}
+	if ((r->has_metrics = s->metrics_sz > 0)) {
+		r->metrics = buf;
+		r->metrics_sz = s->metrics_sz;
+	}
+	return 1;
+}
+
+/*
+ * Return the tier index of "ival" or RING_TIERS if not kept.
+ */
+static size_t
+ring_tier(enum interval ival)
+{
+	size_t	 i;
+
+	for (i = 0; i < RING_TIERS; i++)
+		if (ringivals[i] == ival)
+			break;
+	return i;
+}
+
+/*
+ * Whether records of "ival" are kept in the ring.
+ */
+int
+ring_has(enum interval ival)
+{
+
+	return ring_tier(ival) < RING_TIERS;
+}
+
+/*
+ * Bracket modifications so that readers know to retry.
+ */
+static void
+ring_lock(struct ring *r)
+{
+
+	r->hdr->seq++;
+	__sync_synchronize();
+}
+
+static void
+ring_unlock(struct ring *r)
+{
+
+	__sync_synchronize();
+	r->hdr->seq++;
+}
+
+/*
+ * Create an empty ring file of "qmin" quarter-minute and "min" minute
+ * slots, replacing "file" (if any) so that readers still mapping it
+ * aren't affected.
+ * Returns NULL on failure.
+ */
+struct ring *
+ring_open(const char *file, size_t qmin, size_t min)
+{
+	struct ring	*r;
+	char		*tmp = NULL;
+	size_t		 i, slots[RING_TIERS], total = 0;
+	int		 fd = -1;
+	void		*p;
+
+	slots[0] = qmin;
+	slots[1] = min;
+	for (i = 0; i < RING_TIERS; i++) {
+		if (0 == slots[i] || 
+		    slots[i] > (SIZE_MAX / 2) / sizeof(struct ringslot)) {
+			warnx("%s: bad ring size", file);
+			return NULL;
+		}
+		total += slots[i];
+	}
+
+	if (NULL == (r = calloc(1, sizeof(struct ring)))) {
+		warn(NULL);
+		return NULL;
+	}
+	r->sz = sizeof(struct ringhdr) + total * sizeof(struct ringslot);
+
+	if (-1 == asprintf(&tmp, "%s.new", file)) {
+		warn(NULL);
+		tmp = NULL;
+		goto err;
+	}
+	if (-1 == (fd = open(tmp, O_RDWR|O_CREAT|O_TRUNC, 0644))) {
+		warn("%s", tmp);
+		goto err;
+	} else if (-1 == ftruncate(fd, r->sz)) {
+		warn("%s", tmp);
+		goto err;
+	}
+
+	p = mmap(NULL, r->sz, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	if (MAP_FAILED == p) {
+		warn("%s", tmp);
+		goto err;
+	}
+	r->hdr = p;
+
+	memcpy(r->hdr->magic, RING_MAGIC, sizeof(r->hdr->magic));
+	r->hdr->version = RING_VERSION;
+	r->hdr->slotsz = sizeof(struct ringslot);
+	r->slots[0] = (struct ringslot *)(r->hdr + 1);
+	for (i = 0; i < RING_TIERS; i++) {
+		r->hdr->tiers[i].ival = ringivals[i];
+		r->hdr->tiers[i].slots = slots[i];
+		if (i > 0)
+			r->slots[i] = r->slots[i - 1] + slots[i - 1];
+	}
+
+	if (-1 == rename(tmp, file)) {
+		warn("%s", file);
+		goto err;
+	}
+
+	close(fd);
+	free(tmp);
+	return r;
+err:
+	if (NULL != r->hdr)
+		munmap(r->hdr, r->sz);
+	if (-1 != fd) {
+		unlink(tmp);
+		close(fd);
+	}
+	free(tmp);
+	free(r);
+	return NULL;
+}
+
+void
+ring_close(struct ring *r)
+{
+
+	if (NULL == r)
+		return;
+	munmap(r->hdr, r->sz);
+	free(r);
+}
+
+/*
+ * Append "rec" with per-device rows "d" (or NULL) as the newest record
+ * of its interval, overwriting the oldest if the ring is full.
+ */
+void
+ring_push(struct ring *r, const struct record *rec, 
+	const struct ringdevs *d)
+{
+	struct ringtier	*t;
+	size_t		 i;
+
+	if (RING_TIERS == (i = ring_tier(rec->interval)))
+		return;
+	t = &r->hdr->tiers[i];
+
+	ring_lock(r);
+	if (t->size == t->slots)
+		t->start = (t->start + 1) % t->slots;
+	else
+		t->size++;
+	slot_put(&r->slots[i][(t->start + t->size - 1) % t->slots], 
+		rec, d);
+	ring_unlock(r);
+}
+
+/*
+ * Replace the newest record of the interval of "rec", which must have
+ * been pushed, and its per-device rows with "d" (or NULL).
+ */
+void
+ring_head(struct ring *r, const struct record *rec, 
+	const struct ringdevs *d)
+{
+	struct ringtier	*t;
+	size_t		 i;
+
+	if (RING_TIERS == (i = ring_tier(rec->interval)))
+		return;
+	t = &r->hdr->tiers[i];
+	if (0 == t->size)
+		return;
+
+	ring_lock(r);
+	slot_put(&r->slots[i][(t->start + t->size - 1) % t->slots], 
+		rec, d);
+	ring_unlock(r);
+}
+
+/*
+ * Schedule the mapping to be written back to the file.
+ */
+void
+ring_sync(struct ring *r)
+{
+
+	if (-1 == msync(r->hdr, r->sz, MS_ASYNC))
+		warn("msync");
+}
+
+/*
+ * Read a consistent copy of the records in the ring "file" into "rp"
+ * of size "sz", to be freed by the caller, and their per-device rows
+ * into "dp" (if not NULL), which is within the same allocation.
+ * Records are ordered by interval in the order of "ringivals", then
+ * oldest first; their identifiers are negative and unique among them,
+ * so per-device rows can refer to them, and their summary, cores, and
+ * metrics are null if they weren't kept.
+ * If "sole", there's no writer, so the sequence counter isn't waited
+ * on: if odd, it was left by a writer that died while writing, and
+ * the records are taken as they are.
+ * Returns <0 on failure (errno is set), 0 if the file doesn't exist,
+ * or >0 on success.
+ */
+int
+ring_load(const char *file, int sole, struct record **rp, 
+	struct ringdevs **dp, size_t *sz)
+{
+	struct stat	 st;
+	const struct ringhdr *hdr;
+	struct ringhdr	 h;
+	const struct ringslot *slots;
+	struct ringslot	*buf = NULL;
+	struct record	*rec;
+	struct ringdevs	*devs;
+	unsigned char	*detail;
+	size_t		 i, j, n, total = 0, tries;
+	uint64_t	 seq;
+	void		*p = MAP_FAILED;
+	int		 fd, rc = -1, er;
+
+	*rp = NULL;
+	if (NULL != dp)
+		*dp = NULL;
+	*sz = 0;
+
+	if (-1 == (fd = open(file, O_RDONLY)))
+		return ENOENT == errno ? 0 : -1;
+	if (-1 == fstat(fd, &st))
+		goto out;
+	if ((uint64_t)st.st_size < sizeof(struct ringhdr) ||
+	    (uint64_t)st.st_size > SIZE_MAX / 2) {
+		errno = EINVAL;
+		goto out;
+	}
+	p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (MAP_FAILED == p)
+		goto out;
+	hdr = p;
+	slots = (const struct ringslot *)(hdr + 1);
+
+	/* The geometry doesn't change, so check it just once. */
+
+	errno = EINVAL;
+	if (memcmp(hdr->magic, RING_MAGIC, sizeof(hdr->magic)) ||
+	    RING_VERSION != hdr->version ||
+	    sizeof(struct ringslot) != hdr->slotsz)
+		goto out;
+	for (i = 0; i < RING_TIERS; i++) {
+		if (ringivals[i] != hdr->tiers[i].ival ||
+		    hdr->tiers[i].slots > (uint64_t)st.st_size)
+			goto out;
+		total += hdr->tiers[i].slots;
+	}
+	if ((uint64_t)st.st_size != sizeof(struct ringhdr) + 
+	    total * sizeof(struct ringslot))
+		goto out;
+
+	if (NULL == (buf = reallocarray
+	    (NULL, total + 1, sizeof(struct ringslot))))
+		goto out;
+
+	/*
+	 * Copy out the positions and slots, then make sure that the
+	 * writer didn't touch them meanwhile.
+	 */
+
+	for (tries = 0; tries < RING_TRIES; tries++) {
+		if (tries > 0)
+			sched_yield();
+		if (((seq = hdr->seq) & 1) && ! sole)
+			continue;
+		__sync_synchronize();
+		memcpy(&h, hdr, sizeof(struct ringhdr));
+		memcpy(buf, slots, total * sizeof(struct ringslot));
+		__sync_synchronize();
+		if (seq == hdr->seq)
+			break;
+	}
+	if (RING_TRIES == tries) {
+		errno = EAGAIN;
+		goto out;
+	}
+
+	for (i = 0; i < RING_TIERS; i++)
+		if (h.tiers[i].start >= h.tiers[i].slots ||
+		    h.tiers[i].size > h.tiers[i].slots) {
+			errno = EINVAL;
+			goto out;
+		}
+
+	/* Records, then their devices, then their detail. */
+
+	rec = calloc(1, (total + 1) * (sizeof(struct record) + 
+		sizeof(struct ringdevs) + RING_DETAILSZ));
+	if (NULL == rec)
+		goto out;
+	devs = (struct ringdevs *)(rec + total + 1);
+	detail = (unsigned char *)(devs + total + 1);
+
+	slots = buf;
+	for (n = 0, i = 0; i < RING_TIERS; i++) {
+		for (j = 0; j < h.tiers[i].size; j++, n++) {
+			if ( ! slot_get(&rec[n], &devs[n], 
+			    &slots[(h.tiers[i].start + j) % 
+			     h.tiers[i].slots], 
+			    detail + n * RING_DETAILSZ)) {
+				free(rec);
+				errno = EINVAL;
+				goto out;
+			}
+			rec[n].interval = ringivals[i];
+			rec[n].id = -(int64_t)n - 1;
+		}
+		slots += h.tiers[i].slots;
+	}
+
+	*rp = rec;
+	if (NULL != dp)
+		*dp = devs;
+	*sz = n;
+	rc = 1;
+out:
+	er = errno;
+	free(buf);
+	if (MAP_FAILED != p)
+		munmap(p, st.st_size);
+	close(fd);
+	errno = er;
+	return rc;
+}
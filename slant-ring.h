@@ -0,0 +1,65 @@
+/*	$Id$ */
+/*
+ * Copyright (c) 2018 Kristaps Dzonsons <kristaps@bsd.lv>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef SLANT_RING_H
+#define SLANT_RING_H
+
+/*
+ * Memory-mapped ring file holding the quarter-minute and minute
+ * records in fixed-size slots.
+ * There's one writer, the collector; readers copy out a consistent
+ * view by checking the header's sequence counter, which is odd while
+ * the writer is modifying the file.
+ */
+struct	ring;
+
+/*
+ * One per-device row of a ring record: the interface or disc name and
+ * its received or read and transmitted or written bytes per second,
+ * kept like the ifrecord and discrecord rates.
+ */
+struct	ringdev {
+	char		 name[32]; /* nil-terminated */
+	int64_t		 rx; /* netrx or discread */
+	int64_t		 tx; /* nettx or discwrite */
+};
+
+/*
+ * The per-device rows of a ring record.
+ */
+struct	ringdevs {
+	const struct ringdev *ifs; /* interfaces */
+	size_t		 ifsz; /* number of interfaces */
+	const struct ringdev *discs; /* discs */
+	size_t		 discsz; /* number of discs */
+};
+
+__BEGIN_DECLS
+
+int		 ring_has(enum interval);
+struct ring	*ring_open(const char *, size_t, size_t);
+void		 ring_close(struct ring *);
+void		 ring_push(struct ring *, const struct record *,
+			const struct ringdevs *);
+void		 ring_head(struct ring *, const struct record *,
+			const struct ringdevs *);
+void		 ring_sync(struct ring *);
+int		 ring_load(const char *, int, struct record **,
+			struct ringdevs **, size_t *);
+
+__END_DECLS
+
+#endif /* ! SLANT_RING_H */
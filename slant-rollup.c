@@ -0,0 +1,364 @@
+/*	$Id$ */
+/*
+ * Copyright (c) 2018 Kristaps Dzonsons <kristaps@bsd.lv>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include "config.h"
+
+#if HAVE_SYS_QUEUE
+# include <sys/queue.h>
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "extern.h"
+#include "slant-rollup.h"
+#include "slant-summary.h"
+
+/*
+ * Version of the "metrics" record field written by the collector.
+ */
+#define	METRICS_VERSION 1
+
+/*
+ * One metric of the "metrics" record field.
+ */
+struct	rollmet {
+	uint64_t	 id; /* metric identifier */
+	double		 v; /* sum over the samples */
+};
+
+/*
+ * The summary, cores, and metrics of the records making up a head.
+ * Cores are summed weighted by the records' entries.
+ */
+struct	rollacc {
+	struct summary	 sum; /* merged summaries */
+	int		 hassum; /* whether any had a summary */
+	double		*cores; /* per-core permille times entries */
+	size_t		 coresz; /* number of cores */
+	int64_t		 coreents; /* entries of those with cores */
+	struct rollmet	*mets; /* summed metrics */
+	size_t		 metsz; /* number of metrics */
+	int		 hasmets; /* whether any had metrics */
+};
+
+/*
+ * Combine the I/O latencies of "a" and "b" weighted by their I/Os.
+ * Like the other fields, the result is scaled by the entries, so that
+ * dividing by them gives the mean per I/O.
+ * Without any I/Os to weigh by, they're summed like the others.
+ */
+static double
+await_add(const struct record *a, const struct record *b)
+{
+	double	 ms = 0.0, ios;
+
+	ios = a->disciops + b->disciops;
+	if (ios <= 0.0)
+		return a->discawait + b->discawait;
+	if (a->entries)
+		ms += a->discawait / a->entries * a->disciops;
+	if (b->entries)
+		ms += b->discawait / b->entries * b->disciops;
+	return ms / ios * (a->entries + b->entries);
+}
+
+/*
+ * Accumulate the record "r" into the record "dst".
+ */
+void
+record_add(struct record *dst, const struct record *r)
+{
+
+	dst->discawait = await_add(dst, r);
+	dst->entries += r->entries;
+	dst->cpu += r->cpu;
+	dst->mem += r->mem;
+	dst->nettx += r->nettx;
+	dst->netrx += r->netrx;
+	dst->nettxpkt += r->nettxpkt;
+	dst->netrxpkt += r->netrxpkt;
+	dst->nettxerr += r->nettxerr;
+	dst->netrxerr += r->netrxerr;
+	dst->netcoll += r->netcoll;
+	dst->discread += r->discread;
+	dst->discwrite += r->discwrite;
+	dst->disciops += r->disciops;
+	dst->discbusy += r->discbusy;
+	dst->nprocs += r->nprocs;
+	dst->rprocs += r->rprocs;
+	dst->nfiles += r->nfiles;
+	dst->ctxt += r->ctxt;
+	dst->intr += r->intr;
+	dst->procsrun += r->procsrun;
+	dst->procsblk += r->procsblk;
+	dst->load1 += r->load1;
+	dst->load5 += r->load5;
+	dst->load15 += r->load15;
+	dst->psicpusome += r->psicpusome;
+	dst->psicpufull += r->psicpufull;
+	dst->psimemsome += r->psimemsome;
+	dst->psimemfull += r->psimemfull;
+	dst->psiiosome += r->psiiosome;
+	dst->psiiofull += r->psiiofull;
+}
+
+static int
+get_varint(const unsigned char *buf, size_t sz, size_t *pos, uint64_t *v)
+{
+	unsigned int	 shift;
+
+	for (*v = 0, shift = 0; *pos < sz && shift < 64; shift += 7) {
+		*v |= (uint64_t)(buf[*pos] & 0x7f) << shift;
+		if ( ! (buf[(*pos)++] & 0x80))
+			return 1;
+	}
+	return 0;
+}
+
+static size_t
+put_varint(unsigned char *buf, uint64_t v)
+{
+	size_t	 sz = 0;
+
+	while (v >= 0x80) {
+		buf[sz++] = (v & 0x7f) | 0x80;
+		v >>= 7;
+	}
+	buf[sz++] = v;
+	return sz;
+}
+
+/*
+ * Add the per-core times of "r" to "a".
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+acc_cores(struct rollacc *a, const struct record *r)
+{
+	const unsigned char *buf = r->cores;
+	size_t		 i, sz = r->cores_sz / 2;
+	void		*pp;
+
+	if (sz > a->coresz) {
+		if (NULL == (pp = reallocarray(a->cores, sz, sizeof(double))))
+			return 0;
+		a->cores = pp;
+		for (i = a->coresz; i < sz; i++)
+			a->cores[i] = 0.0;
+		a->coresz = sz;
+	}
+	for (i = 0; i < sz; i++)
+		a->cores[i] += (buf[i * 2] | (buf[i * 2 + 1] << 8)) * 
+			(double)r->entries;
+	a->coreents += r->entries;
+	return 1;
+}
+
+/*
+ * Add the metrics of "r" to "a", ignoring them if malformed.
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+acc_metrics(struct rollacc *a, const struct record *r)
+{
+	const unsigned char *buf = r->metrics;
+	uint64_t	 n, id, v;
+	size_t		 i, j, k, pos = 1, sz = r->metrics_sz;
+	double		 d;
+	void		*pp;
+
+	if (0 == sz || METRICS_VERSION != buf[0] ||
+	    ! get_varint(buf, sz, &pos, &n))
+		return 1;
+
+	a->hasmets = 1;
+	for (i = 0; i < n; i++) {
+		if ( ! get_varint(buf, sz, &pos, &id) || sz - pos < 8)
+			return 1;
+		for (v = 0, j = 0; j < 8; j++)
+			v |= (uint64_t)buf[pos++] << (j * 8);
+		memcpy(&d, &v, sizeof(double));
+		for (k = 0; k < a->metsz; k++)
+			if (a->mets[k].id == id)
+				break;
+		if (k == a->metsz) {
+			pp = reallocarray(a->mets, 
+				a->metsz + 1, sizeof(struct rollmet));
+			if (NULL == pp)
+				return 0;
+			a->mets = pp;
+			a->mets[a->metsz].id = id;
+			a->mets[a->metsz++].v = 0.0;
+		}
+		a->mets[k].v += d;
+	}
+	return 1;
+}
+
+/*
+ * Add the summary, cores, and metrics of "r" to "a".
+ * Return zero on memory failure, non-zero on success.
+ */
+static int
+acc_add(struct rollacc *a, const struct record *r)
+{
+	struct summary	 s;
+
+	if (r->has_summary && 
+	    summary_decode(&s, r->summary, r->summary_sz)) {
+		summary_merge(&a->sum, &s);
+		a->hassum = 1;
+	}
+	if (r->has_cores && r->cores_sz >= 2 && ! acc_cores(a, r))
+		return 0;
+	if (r->has_metrics && ! acc_metrics(a, r))
+		return 0;
+	return 1;
+}
+
+/*
+ * Encode "a" as the summary, cores, and metrics of "h", freeing those
+ * it had.
+ * Those that can't be allocated are null.
+ */
+static void
+acc_put(const struct rollacc *a, struct record *h)
+{
+	unsigned char	*buf;
+	uint64_t	 v;
+	size_t		 i, j, pos = 0;
+	double		 d;
+
+	free(h->summary);
+	free(h->cores);
+	free(h->metrics);
+	h->summary = h->cores = h->metrics = NULL;
+	h->summary_sz = h->cores_sz = h->metrics_sz = 0;
+
+	if (a->hassum)
+		h->summary = summary_encode(&a->sum, &h->summary_sz);
+	h->has_summary = NULL != h->summary;
+
+	if (a->coresz > 0 && a->coreents > 0 &&
+	    NULL != (buf = reallocarray(NULL, a->coresz, 2))) {
+		for (i = 0; i < a->coresz; i++) {
+			d = a->cores[i] / a->coreents + 0.5;
+			d = d > 1000.0 ? 1000.0 : d < 0.0 ? 0.0 : d;
+			buf[i * 2] = (unsigned int)d & 0xff;
+			buf[i * 2 + 1] = (unsigned int)d >> 8;
+		}
+		h->cores = buf;
+		h->cores_sz = a->coresz * 2;
+	}
+	h->has_cores = NULL != h->cores;
+
+	if (a->hasmets && a->metsz > 0 &&
+	    NULL != (buf = malloc(1 + 10 + a->metsz * 18))) {
+		buf[pos++] = METRICS_VERSION;
+		pos += put_varint(buf + pos, a->metsz);
+		for (i = 0; i < a->metsz; i++) {
+			pos += put_varint(buf + pos, a->mets[i].id);
+			memcpy(&v, &a->mets[i].v, sizeof(double));
+			for (j = 0; j < 8; j++)
+				buf[pos++] = v >> (j * 8);
+		}
+		h->metrics = buf;
+		h->metrics_sz = pos;
+	}
+	h->has_metrics = NULL != h->metrics;
+}
+
+/*
+ * Whether "r" is one of the older finer records making up the head "h"
+ * in rollup(), given the newest record "f" of the next finer interval.
+ * The newest, "f", is itself part of "h" if started since.
+ */
+int
+rollup_part(const struct record *h, 
+	const struct record *f, const struct record *r)
+{
+
+	return r->interval == f->interval &&
+		r->ctime >= h->ctime && r->ctime < f->ctime;
+}
+
+/*
+ * Recompute the newest record of each interval from those of the next
+ * finer one, as the collector doesn't write it in rollup mode.
+ * A coarse record starting also starts all finer ones, so its samples
+ * are exactly those of the finer records started since.
+ * "heads" are the newest records (or NULL) indexed by interval, and
+ * each from "first" (at least one) is recomputed in place from the one
+ * before, itself recomputed, and the older finer records among the
+ * "sz" records "r", as found by rollup_part().
+ * Their summaries and metrics are merged and their cores averaged,
+ * replacing (and freeing) those they had, so they must have been
+ * allocated; any that can't be allocated are null.
+ */
+void
+rollup(struct record *const *heads, size_t first, 
+	const struct record *const *r, size_t sz)
+{
+	struct record	*h;
+	const struct record *f;
+	struct rollacc	 acc;
+	size_t		 i, j;
+	int		 rc;
+
+	for (i = first; i < ROLLUP_IVALS; i++) {
+		if (NULL == (h = heads[i]) || NULL == (f = heads[i - 1]))
+			continue;
+		h->entries = 0;
+		h->cpu = h->mem = 0.0;
+		h->nettx = h->netrx = 0;
+		h->nettxpkt = h->netrxpkt = 0;
+		h->nettxerr = h->netrxerr = h->netcoll = 0;
+		h->discread = h->discwrite = h->disciops = 0;
+		h->discawait = h->discbusy = 0.0;
+		h->nprocs = h->rprocs = h->nfiles = 0.0;
+		h->ctxt = h->intr = 0;
+		h->procsrun = h->procsblk = 0.0;
+		h->load1 = h->load5 = h->load15 = 0.0;
+		h->psicpusome = h->psicpufull = 0.0;
+		h->psimemsome = h->psimemfull = 0.0;
+		h->psiiosome = h->psiiofull = 0.0;
+
+		memset(&acc, 0, sizeof(struct rollacc));
+		rc = 1;
+		if (f->ctime >= h->ctime) {
+			record_add(h, f);
+			rc = acc_add(&acc, f);
+		}
+		for (j = 0; j < sz; j++)
+			if (rollup_part(h, f, r[j])) {
+				record_add(h, r[j]);
+				rc = rc && acc_add(&acc, r[j]);
+			}
+
+		/* On memory failure, they're all null. */
+
+		if ( ! rc) {
+			acc.hassum = acc.hasmets = 0;
+			acc.coresz = 0;
+		}
+		acc_put(&acc, h);
+		free(acc.cores);
+		free(acc.mets);
+	}
+}
@@ -0,0 +1,36 @@
+/*	$Id$ */
+/*
+ * Copyright (c) 2018 Kristaps Dzonsons <kristaps@bsd.lv>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef SLANT_ROLLUP_H
+#define SLANT_ROLLUP_H
+
+/*
+ * Intervals whose newest record is recomputed in rollup mode, each
+ * from the one before: those of enum interval from byqmin to byyear.
+ */
+#define	ROLLUP_IVALS 6
+
+__BEGIN_DECLS
+
+void	 record_add(struct record *, const struct record *);
+void	 rollup(struct record *const *, size_t,
+		const struct record *const *, size_t);
+int	 rollup_part(const struct record *, 
+		const struct record *, const struct record *);
+
+__END_DECLS
+
+#endif /* ! SLANT_ROLLUP_H */
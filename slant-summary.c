@@ -0,0 +1,358 @@
+/*	$Id$ */
+/*
+ * Copyright (c) 2018 Kristaps Dzonsons <kristaps@bsd.lv>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include "config.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "slant-summary.h"
+
+/*
+ * Version of the encoding in summary_encode().
+ */
+#define	SUMMARY_VERSION 2
+
+/*
+ * Version 1 had only the metrics up to SUMMET_NFILES.
+ */
+#define	SUMMARY_V1_MAX (SUMMET_NFILES + 1)
+
+/*
+ * Buckets per doubling of rate buckets.
+ */
+#define	SUMMARY_LOGSTEP 1.5
+
+/*
+ * Whether the metric is a rate or other unbounded value (log buckets)
+ * or percentage (linear).
+ */
+static	const int sumlog[SUMMET__MAX] = {
+	0, /* SUMMET_CPU */
+	0, /* SUMMET_MEM */
+	1, /* SUMMET_NETTX */
+	1, /* SUMMET_NETRX */
+	1, /* SUMMET_DISCREAD */
+	1, /* SUMMET_DISCWRITE */
+	0, /* SUMMET_NPROCS */
+	0, /* SUMMET_RPROCS */
+	0, /* SUMMET_NFILES */
+	1, /* SUMMET_NETTXPKT */
+	1, /* SUMMET_NETRXPKT */
+	1, /* SUMMET_NETTXERR */
+	1, /* SUMMET_NETRXERR */
+	1, /* SUMMET_NETCOLL */
+	1, /* SUMMET_DISCIOPS */
+	1, /* SUMMET_DISCAWAIT */
+	0, /* SUMMET_DISCBUSY */
+	1, /* SUMMET_CTXT */
+	1, /* SUMMET_INTR */
+	1, /* SUMMET_PROCSRUN */
+	1, /* SUMMET_PROCSBLK */
+	1, /* SUMMET_LOAD1 */
+	1, /* SUMMET_LOAD5 */
+	1, /* SUMMET_LOAD15 */
+	0, /* SUMMET_PSICPUSOME */
+	0, /* SUMMET_PSICPUFULL */
+	0, /* SUMMET_PSIMEMSOME */
+	0, /* SUMMET_PSIMEMFULL */
+	0, /* SUMMET_PSIIOSOME */
+	0, /* SUMMET_PSIIOFULL */
+};
+
+/*
+ * Bucket holding "v" for the metric.
+ * Rate bucket zero holds everything below one.
+ */
+static size_t
+bucket_get(enum summet m, double v)
+{
+	double	 k;
+
+	if (sumlog[m])
+		k = v < 1.0 ? 0.0 :
+			1.0 + floor(log2(v) * SUMMARY_LOGSTEP);
+	else
+		k = floor(v * SUMMARY_BUCKETS / 100.0);
+
+	if (k < 0.0)
+		return 0;
+	if (k > SUMMARY_BUCKETS - 1)
+		return SUMMARY_BUCKETS - 1;
+	return k;
+}
+
+/*
+ * Lower and upper bounds of bucket "k" for the metric.
+ */
+static void
+bucket_bounds(enum summet m, size_t k, double *lo, double *hi)
+{
+
+	if ( ! sumlog[m]) {
+		*lo = k * 100.0 / SUMMARY_BUCKETS;
+		*hi = (k + 1) * 100.0 / SUMMARY_BUCKETS;
+	} else if (0 == k) {
+		*lo = 0.0;
+		*hi = 1.0;
+	} else {
+		*lo = exp2((k - 1) / SUMMARY_LOGSTEP);
+		*hi = exp2(k / SUMMARY_LOGSTEP);
+	}
+}
+
+void
+summary_init(struct summary *s)
+{
+
+	memset(s, 0, sizeof(struct summary));
+}
+
+/*
+ * Add the sample "v" of metric "m".
+ */
+void
+summary_add(struct summary *s, enum summet m, double v)
+{
+	struct sumstat	*st = &s->stats[m];
+
+	if (0 == st->count || v < st->min)
+		st->min = v;
+	if (0 == st->count || v > st->max)
+		st->max = v;
+	st->count++;
+	st->bucket[bucket_get(m, v)]++;
+}
+
+/*
+ * Merge all samples of "src" into "dst".
+ */
+void
+summary_merge(struct summary *dst, const struct summary *src)
+{
+	struct sumstat		*d;
+	const struct sumstat	*s;
+	size_t			 i, j;
+
+	for (i = 0; i < SUMMET__MAX; i++) {
+		d = &dst->stats[i];
+		s = &src->stats[i];
+		if (0 == s->count)
+			continue;
+		if (0 == d->count || s->min < d->min)
+			d->min = s->min;
+		if (0 == d->count || s->max > d->max)
+			d->max = s->max;
+		d->count += s->count;
+		for (j = 0; j < SUMMARY_BUCKETS; j++)
+			d->bucket[j] += s->bucket[j];
+	}
+}
+
+/*
+ * Estimate quantile "q" (from 0 to 1) of metric "m" by interpolating
+ * within the bucket holding it, linearly or geometrically for rates.
+ * The estimate is always within the minimum and maximum.
+ * Returns zero if there are no samples.
+ */
+double
+summary_quantile(const struct summary *s, enum summet m, double q)
+{
+	const struct sumstat *st = &s->stats[m];
+	double		 rank, cum = 0.0, lo, hi, f, v;
+	size_t		 k;
+
+	if (0 == st->count)
+		return 0.0;
+
+	rank = q * st->count;
+	for (k = 0; k < SUMMARY_BUCKETS - 1; k++) {
+		if (0 == st->bucket[k])
+			continue;
+		if (cum + st->bucket[k] >= rank)
+			break;
+		cum += st->bucket[k];
+	}
+
+	bucket_bounds(m, k, &lo, &hi);
+	f = 0 == st->bucket[k] ? 1.0 : (rank - cum) / st->bucket[k];
+
+	if (sumlog[m] && k > 0)
+		v = lo * pow(hi / lo, f);
+	else
+		v = lo + (hi - lo) * f;
+
+	if (v < st->min)
+		return st->min;
+	if (v > st->max)
+		return st->max;
+	return v;
+}
+
+static size_t
+put_varint(unsigned char *buf, uint64_t v)
+{
+	size_t	 sz = 0;
+
+	while (v >= 0x80) {
+		buf[sz++] = (v & 0x7f) | 0x80;
+		v >>= 7;
+	}
+	buf[sz++] = v;
+	return sz;
+}
+
+static int
+get_varint(const unsigned char **buf,
+	const unsigned char *end, uint64_t *v)
+{
+	unsigned int	 shift = 0;
+
+	*v = 0;
+	while (*buf < end && shift < 64) {
+		*v |= (uint64_t)(**buf & 0x7f) << shift;
+		if ( ! (*(*buf)++ & 0x80))
+			return 1;
+		shift += 7;
+	}
+	return 0;
+}
+
+static size_t
+put_double(unsigned char *buf, double d)
+{
+	uint64_t	 v;
+	size_t		 i;
+
+	memcpy(&v, &d, sizeof(double));
+	for (i = 0; i < 8; i++)
+		buf[i] = v >> (i * 8);
+	return 8;
+}
+
+static int
+get_double(const unsigned char **buf,
+	const unsigned char *end, double *d)
+{
+	uint64_t	 v = 0;
+	size_t		 i;
+
+	if (end - *buf < 8)
+		return 0;
+	for (i = 0; i < 8; i++)
+		v |= (uint64_t)(*buf)[i] << (i * 8);
+	memcpy(d, &v, sizeof(double));
+	*buf += 8;
+	return 1;
+}
+
+/*
+ * Serialise the summary as follows, with integers as unsigned LEB128
+ * and reals as little-endian IEEE 754 doubles.
+ * The leading byte is the version.
+ * Then for each metric, in order, the sample count; if non-zero, the
+ * minimum, maximum, number of non-empty buckets, and each of those as
+ * a byte index followed by its count.
+ * Returns the buffer of size "sz" or NULL on memory exhaustion.
+ */
+void *
+summary_encode(const struct summary *s, size_t *sz)
+{
+	unsigned char		*buf;
+	const struct sumstat	*st;
+	size_t			 i, j, n, pos = 0;
+
+	/* Worst case: every bucket filled with a 10-byte varint. */
+
+	buf = malloc(1 + SUMMET__MAX *
+		(10 + 16 + 10 + SUMMARY_BUCKETS * 11));
+	if (NULL == buf)
+		return NULL;
+
+	buf[pos++] = SUMMARY_VERSION;
+	for (i = 0; i < SUMMET__MAX; i++) {
+		st = &s->stats[i];
+		pos += put_varint(buf + pos, st->count);
+		if (0 == st->count)
+			continue;
+		pos += put_double(buf + pos, st->min);
+		pos += put_double(buf + pos, st->max);
+		for (n = j = 0; j < SUMMARY_BUCKETS; j++)
+			n += 0 != st->bucket[j];
+		pos += put_varint(buf + pos, n);
+		for (j = 0; j < SUMMARY_BUCKETS; j++) {
+			if (0 == st->bucket[j])
+				continue;
+			buf[pos++] = j;
+			pos += put_varint(buf + pos, st->bucket[j]);
+		}
+	}
+
+	*sz = pos;
+	return buf;
+}
+
+/*
+ * Parse a summary serialised with summary_encode().
+ * Version 1 summaries are also accepted, leaving the metrics they
+ * lack without samples.
+ * Returns zero if malformed or of another version, non-zero on
+ * success.
+ */
+int
+summary_decode(struct summary *s, const void *p, size_t sz)
+{
+	const unsigned char	*buf = p, *end = buf + sz;
+	struct sumstat		*st;
+	uint64_t		 n, v;
+	size_t			 i, j, max;
+
+	summary_init(s);
+
+	if (0 == sz)
+		return 0;
+	else if (SUMMARY_VERSION == *buf)
+		max = SUMMET__MAX;
+	else if (1 == *buf)
+		max = SUMMARY_V1_MAX;
+	else
+		return 0;
+	buf++;
+
+	for (i = 0; i < max; i++) {
+		st = &s->stats[i];
+		if ( ! get_varint(&buf, end, &st->count))
+			return 0;
+		if (0 == st->count)
+			continue;
+		if ( ! get_double(&buf, end, &st->min) ||
+		    ! get_double(&buf, end, &st->max) ||
+		    ! get_varint(&buf, end, &n) ||
+		    n > SUMMARY_BUCKETS)
+			return 0;
+		for (j = 0; j < n; j++) {
+			if (buf == end || *buf >= SUMMARY_BUCKETS)
+				return 0;
+			v = *buf++;
+			if ( ! get_varint(&buf, end, &st->bucket[v]))
+				return 0;
+		}
+	}
+
+	return buf == end;
+}
@@ -0,0 +1,90 @@
+/*	$Id$ */
+/*
+ * Copyright (c) 2018 Kristaps Dzonsons <kristaps@bsd.lv>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef SLANT_SUMMARY_H
+#define SLANT_SUMMARY_H
+
+/*
+ * Metrics of a record that are summarised, in their encoded order.
+ */
+enum	summet {
+	SUMMET_CPU = 0, /* cpu */
+	SUMMET_MEM, /* mem */
+	SUMMET_NETTX, /* nettx */
+	SUMMET_NETRX, /* netrx */
+	SUMMET_DISCREAD, /* discread */
+	SUMMET_DISCWRITE, /* discwrite */
+	SUMMET_NPROCS, /* nprocs */
+	SUMMET_RPROCS, /* rprocs */
+	SUMMET_NFILES, /* nfiles */
+	SUMMET_NETTXPKT, /* nettxpkt */
+	SUMMET_NETRXPKT, /* netrxpkt */
+	SUMMET_NETTXERR, /* nettxerr */
+	SUMMET_NETRXERR, /* netrxerr */
+	SUMMET_NETCOLL, /* netcoll */
+	SUMMET_DISCIOPS, /* disciops */
+	SUMMET_DISCAWAIT, /* discawait */
+	SUMMET_DISCBUSY, /* discbusy */
+	SUMMET_CTXT, /* ctxt */
+	SUMMET_INTR, /* intr */
+	SUMMET_PROCSRUN, /* procsrun */
+	SUMMET_PROCSBLK, /* procsblk */
+	SUMMET_LOAD1, /* load1 */
+	SUMMET_LOAD5, /* load5 */
+	SUMMET_LOAD15, /* load15 */
+	SUMMET_PSICPUSOME, /* psicpusome */
+	SUMMET_PSICPUFULL, /* psicpufull */
+	SUMMET_PSIMEMSOME, /* psimemsome */
+	SUMMET_PSIMEMFULL, /* psimemfull */
+	SUMMET_PSIIOSOME, /* psiiosome */
+	SUMMET_PSIIOFULL, /* psiiofull */
+	SUMMET__MAX
+};
+
+#define	SUMMARY_BUCKETS 64
+
+/*
+ * Streaming summary of one metric's samples: the extremes and a
+ * histogram from which quantiles are estimated.
+ * Percentages have linear buckets over [0, 100]; rates and other
+ * unbounded values have buckets growing by a factor of 2^(2/3) from
+ * one.
+ * Two summaries merge by adding buckets, so coarse records needn't
+ * have the samples of the fine ones.
+ */
+struct	sumstat {
+	uint64_t	 count; /* number of samples */
+	double		 min; /* smallest sample (if count) */
+	double		 max; /* largest sample (if count) */
+	uint64_t	 bucket[SUMMARY_BUCKETS]; /* samples per bucket */
+};
+
+struct	summary {
+	struct sumstat	 stats[SUMMET__MAX];
+};
+
+__BEGIN_DECLS
+
+void	 summary_init(struct summary *);
+void	 summary_add(struct summary *, enum summet, double);
+void	 summary_merge(struct summary *, const struct summary *);
+double	 summary_quantile(const struct summary *, enum summet, double);
+void	*summary_encode(const struct summary *, size_t *);
+int	 summary_decode(struct summary *, const void *, size_t);
+
+__END_DECLS
+
+#endif /* ! SLANT_SUMMARY_H */
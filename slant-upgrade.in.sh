@@ -73,7 +73,11 @@ then
 	exit 1
 fi
 
-sqlite3 "@DATADIR@/slant.db" < $TMPFILE
+# Wait on the collector and any readers rather than failing if the
+# database is busy.
+
+( echo ".timeout 10000" ; cat $TMPFILE ; ) | \
+	sqlite3 "@DATADIR@/slant.db"
 install -m 0444 "$KWBP" "@DATADIR@/slant.kwbp"
 rm -f "@DATADIR@/slant-upgrade.sql"
 echo "@DATADIR@/slant.db: patch success"
@@ -65,12 +65,16 @@ recset_free(struct recset *r)
 
 	free(r->version);
 	jsmn_system_clear(&r->system);
+	jsmn_record_free_array(r->bysec, r->bysecsz);
 	jsmn_record_free_array(r->byqmin, r->byqminsz);
 	jsmn_record_free_array(r->bymin, r->byminsz);
 	jsmn_record_free_array(r->byhour, r->byhoursz);
 	jsmn_record_free_array(r->byday, r->bydaysz);
 	jsmn_record_free_array(r->byweek, r->byweeksz);
 	jsmn_record_free_array(r->byyear, r->byyearsz);
+	jsmn_ifrecord_free_array(r->ifs, r->ifsz);
+	jsmn_discrecord_free_array(r->discs, r->discsz);
+	jsmn_metric_free_array(r->metrics, r->metricsz);
 }
 
 static void
@@ -422,11 +426,30 @@ layout(struct config *cfg, struct out *out, size_t maxx,
 	return maxx > compute_width(n, nsz, d);
 }
 
+/*
+ * Append the query key "key" to the node's request path.
+ * The CGI only sends the arrays of newer versions when asked, so that
+ * older clients don't choke on them.
+ */
+static void
+path_key(struct node *n, const char *key)
+{
+	char	*cp;
+
+	if (-1 == asprintf(&cp, "%s%c%s", n->path,
+	    NULL == strchr(n->path, '?') ? '?' : '&', key))
+		err(EXIT_FAILURE, NULL);
+	free(n->path);
+	n->path = cp;
+}
+
 int
 main(int argc, char *argv[])
 {
 	int	 	 c, first = 1, maxy, maxx;
-	size_t		 i, sz;
+	size_t		 i, j, sz;
+	int		 devices = 0, metrics = 0, sec = 0;
+	const struct drawbox *box;
 	const char	*cfgfile = NULL;
 	struct node	*n = NULL;
 	struct pollfd	*pfds = NULL;
@@ -570,6 +593,26 @@ main(int argc, char *argv[])
 	if (NULL == pfds)
 		err(EXIT_FAILURE, NULL);
 
+	/* 
+	 * Only ask for per-second records, per-device rows, and
+	 * metrics if we show them.
+	 * Host and link lines use their own bits, not the LINE_xxx.
+	 */
+
+	for (i = 0; NULL != cfg.draw && i < cfg.draw->boxsz; i++) {
+		box = &cfg.draw->box[i];
+		if (DRAWCAT_TOPNET == box->cat ||
+		    DRAWCAT_TOPDISC == box->cat)
+			devices = 1;
+		else if (DRAWCAT_METRIC == box->cat)
+			metrics = 1;
+		if (DRAWCAT_HOST == box->cat || DRAWCAT_LINK == box->cat)
+			continue;
+		for (j = 0; j < 6; j++)
+			if ((LINE_SEC | LINE_SEC_BARS) & box->lines[j].line)
+				sec = 1;
+	}
+
 	for (i = 0; i < cfg.urlsz; i++) {
 		pfds[i].fd = -1;
 		n[i].xfer.pfd = &pfds[i];
@@ -582,6 +625,12 @@ main(int argc, char *argv[])
 			cfg.urls[i].timeout ?
 			cfg.urls[i].timeout : (time_t)cfg.timeout;
 		dns_parse_url(&out, &n[i]);
+		if (sec)
+			path_key(&n[i], "sec");
+		if (devices)
+			path_key(&n[i], "devices");
+		if (metrics)
+			path_key(&n[i], "metrics");
 	}
 
 	/* 
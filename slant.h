@@ -43,12 +43,24 @@ enum	drawcat {
 	DRAWCAT_CPU,
 	DRAWCAT_MEM,
 	DRAWCAT_NET,
+	DRAWCAT_NETPKT,
+	DRAWCAT_NETERR,
 	DRAWCAT_DISC,
+	DRAWCAT_DISCLAT,
 	DRAWCAT_LINK,
 	DRAWCAT_HOST,
 	DRAWCAT_PROCS,
 	DRAWCAT_FILES,
-	DRAWCAT_RPROCS
+	DRAWCAT_RPROCS,
+	DRAWCAT_CORES,
+	DRAWCAT_TOPNET,
+	DRAWCAT_TOPDISC,
+	DRAWCAT_SCHED,
+	DRAWCAT_RUNQ,
+	DRAWCAT_LOAD,
+	DRAWCAT_PSI,
+	DRAWCAT_PSIFULL,
+	DRAWCAT_METRIC
 };
 
 /*
@@ -66,12 +78,14 @@ struct	drawboxln {
 #define	LINE_DAY	 0x0008
 #define LINE_WEEK	 0x0010
 #define LINE_YEAR	 0x0020
+#define	LINE_SEC	 0x0040
 #define	LINE_QMIN_BARS	 0x0100
 #define	LINE_MIN_BARS	 0x0200
 #define	LINE_HOUR_BARS	 0x0400
 #define	LINE_DAY_BARS	 0x0800
 #define	LINE_WEEK_BARS	 0x1000
 #define	LINE_YEAR_BARS	 0x2000
+#define	LINE_SEC_BARS	 0x4000
 #define	LINK_IP		 0x0001
 #define LINK_STATE	 0x0002
 #define LINK_ACCESS	 0x0004
@@ -91,6 +105,7 @@ struct	drawboxln {
  */
 struct	drawbox {
 	enum drawcat	 cat; /* the box category */
+	char		*metric; /* name if DRAWCAT_METRIC */
 	size_t		 len; /* maximum length for contents */
 	struct drawboxln lines[6]; /* our drawables */
 };
@@ -126,6 +141,8 @@ struct	recset {
 	int64_t		 timestamp;
 	int		 has_system;
 	struct system	 system;
+	struct record	*bysec;
+	size_t		 bysecsz;
 	struct record	*byqmin;
 	size_t		 byqminsz;
 	struct record	*bymin;
@@ -138,6 +155,12 @@ struct	recset {
 	size_t		 byweeksz;
 	struct record	*byyear;
 	size_t		 byyearsz;
+	struct ifrecord	*ifs; /* interfaces of newest records */
+	size_t		 ifsz;
+	struct discrecord *discs; /* discs of newest records */
+	size_t		 discsz;
+	struct metric	*metrics; /* names of record metrics */
+	size_t		 metricsz;
 };
 
 enum	state {